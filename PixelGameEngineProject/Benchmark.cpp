@@ -0,0 +1,423 @@
+/*
+	Headless benchmark for the Vertlet solver, no PixelGameEngine instance or window is created
+
+	Linux:
+	g++ -O2 -std=c++17 -o VertletBenchmark Benchmark.cpp VertletPhysics.cpp VertletShapeMatch.cpp VertletForceField.cpp VertletWorld.cpp VertletFluid.cpp VertletParallel.cpp VertletRewind.cpp VertletExport.cpp VertletSweep.cpp VertletBuilder.cpp VertletPrototype.cpp VertletQuality.cpp VertletBatch.cpp VertletPartition.cpp -lpthread
+
+	Usage:
+	./VertletBenchmark [frames] > results.json
+	./VertletBenchmark sweep [frames] [results.csv] [configs.csv]
+
+	Sweeps net sizes, constrain loop counts, chain body counts and thread counts, then writes
+	one JSON object per configuration with frame time percentiles, ns per point per iteration
+	and throughput. Nets are a single body so they always run on one thread, partitioned nets
+	split that body's stick pass across the threads, chain scenes are split across threads by
+	box/chain pair as the chain sticks reach into the box body.
+
+	Sweep mode steps one independent world per parameter set, one world per hardware thread at a
+	time, and writes energy, stretch and step time per set as CSV. configs.csv rows are
+	bounce,gravity,friction,constrain_loops,substeps[,tear_ratio], without one a built in grid is used.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "VertletPartition.h"
+#include "VertletPhysics.h"
+#include "VertletSweep.h"
+
+namespace
+{
+	using namespace VertletPhysics;
+	using Clock = std::chrono::steady_clock;
+
+	/* Frames run before timing starts */
+	const int32_t g_warmup_frames = 5;
+	/* A configuration stops early once it has been timed for this long */
+	const double g_max_config_seconds = 3.0;
+	/* Mouse parked off screen so no point is ever touched, close enough to stay inside the Q16.16 range */
+	const olc::vf2d g_mouse_pos{ -1000.f, -1000.f };
+	/* Rows of chains before the layout wraps back to the top, keeps every coordinate inside the Q16.16 range */
+	const int32_t g_max_chain_rows = 50;
+
+	/**
+	 * \brief Single benchmark configuration
+	 */
+	struct BenchConfig
+	{
+		std::string m_scenario;
+		int32_t m_net_size;
+		int32_t m_chain_count;
+		int32_t m_constrain_loops;
+		int32_t m_threads;
+	};
+
+	/**
+	 * \brief Reusable barrier, std::barrier is C++20
+	 */
+	class FrameBarrier
+	{
+	public:
+		explicit FrameBarrier(const int32_t count) : m_count(count), m_waiting(0), m_generation(0) {}
+
+		void Wait()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			const int32_t generation = m_generation;
+
+			if (++m_waiting == m_count)
+			{
+				m_waiting = 0;
+				m_generation++;
+				m_cv.notify_all();
+				return;
+			}
+
+			m_cv.wait(lock, [&] { return generation != m_generation; });
+		}
+
+	private:
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		const int32_t m_count;
+		int32_t m_waiting;
+		int32_t m_generation;
+	};
+
+	/**
+	 * \brief Get a percentile from sorted samples
+	 * \param sorted Ascending samples
+	 * \param percent 0 - 100
+	 * \return Nearest rank sample
+	 */
+	double Percentile(const std::vector<double>& sorted, const double percent)
+	{
+		const size_t rank = static_cast<size_t>(percent / 100.0 * (sorted.size() - 1) + 0.5);
+		return sorted[std::min(rank, sorted.size() - 1)];
+	}
+
+	/**
+	 * \brief Build the scene, step it and print the result as a JSON object
+	 * \param config Configuration to run
+	 * \param frames Number of timed frames
+	 * \param first True if this is the first object in the results array
+	 */
+	void RunConfig(const BenchConfig& config, const int32_t frames, const bool first)
+	{
+		// one group of bodies per worker thread
+		std::vector<std::vector<VertletBody*>> groups(config.m_threads);
+		int32_t screen_width = 0;
+		int32_t screen_height = 0;
+
+		if (config.m_net_size > 0)
+		{
+			const Real point_dist = 5;
+			CreateNet(groups[0], 10, 10, config.m_net_size, config.m_net_size, point_dist);
+
+			// one body split across the threads, the other benchmark threads have nothing to update
+			if (config.m_scenario == "partitioned_net")
+			{
+				groups[0][0] = PartitionedBody::Adopt(groups[0][0], config.m_threads);
+			}
+			screen_width = config.m_net_size * 5 + 20;
+			screen_height = config.m_net_size * 10 + 20;
+		}
+		else
+		{
+			const int32_t per_row = 50;
+			for (int32_t i = 0; i < config.m_chain_count; i++)
+			{
+				const Real x = (i % per_row) * 250;
+				// chains never touch each other, so a wrapped row costs the same as a fresh one
+				const Real y = (i / per_row % g_max_chain_rows) * 300;
+				CreateChain(x, y, groups[i % config.m_threads]);
+			}
+			screen_width = per_row * 250 + 250;
+			screen_height = std::min(config.m_chain_count / per_row + 1, g_max_chain_rows) * 300 + 300;
+		}
+
+		size_t point_count = 0;
+		size_t stick_count = 0;
+		for (const auto& group : groups)
+		{
+			for (const auto* body : group)
+			{
+				point_count += body->m_points.size();
+				stick_count += body->m_sticks.size();
+			}
+		}
+
+		const int32_t total_frames = g_warmup_frames + frames;
+		std::vector<double> frame_ns;
+		frame_ns.reserve(frames);
+
+		VertletSettings settings;
+		settings.m_constrain_loops = config.m_constrain_loops;
+
+		FrameBarrier barrier(config.m_threads);
+		std::atomic<bool> stop{ false };
+		Clock::time_point frame_start;
+		const Clock::time_point config_start = Clock::now();
+
+		auto worker = [&](const int32_t index)
+		{
+			for (int32_t frame = 0; frame < total_frames; frame++)
+			{
+				barrier.Wait();
+
+				if (stop.load(std::memory_order_relaxed))
+				{
+					return;
+				}
+
+				if (index == 0)
+				{
+					frame_start = Clock::now();
+				}
+
+				for (auto* body : groups[index])
+				{
+					body->Update(screen_width, screen_height, { 0, 0 }, g_mouse_pos, false, settings);
+				}
+
+				barrier.Wait();
+
+				if (index == 0)
+				{
+					const Clock::time_point now = Clock::now();
+
+					if (frame >= g_warmup_frames)
+					{
+						frame_ns.push_back(std::chrono::duration<double, std::nano>(now - frame_start).count());
+					}
+
+					// large nets are capped by time rather than frame count
+					const bool over_time = std::chrono::duration<double>(now - config_start).count() > g_max_config_seconds;
+					stop.store(over_time && frame_ns.size() >= 5, std::memory_order_relaxed);
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (int32_t t = 1; t < config.m_threads; t++)
+		{
+			threads.emplace_back(worker, t);
+		}
+		worker(0);
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		for (auto& group : groups)
+		{
+			for (auto* body : group)
+			{
+				delete body;
+			}
+		}
+
+		std::vector<double> sorted = frame_ns;
+		std::sort(sorted.begin(), sorted.end());
+
+		double total_ns = 0;
+		for (const double ns : frame_ns)
+		{
+			total_ns += ns;
+		}
+
+		const double mean_ns = total_ns / frame_ns.size();
+		const double point_iterations = static_cast<double>(point_count) * config.m_constrain_loops;
+
+		printf("%s  {\"scenario\": \"%s\", \"net_size\": %d, \"chains\": %d, \"constrain_loops\": %d, \"threads\": %d, "
+			"\"points\": %zu, \"sticks\": %zu, \"frames\": %zu, "
+			"\"frame_ns\": {\"mean\": %.0f, \"min\": %.0f, \"p50\": %.0f, \"p90\": %.0f, \"p99\": %.0f, \"max\": %.0f}, "
+			"\"ns_per_point_iteration\": %.3f, \"point_iterations_per_second\": %.0f, \"frames_per_second\": %.2f}",
+			first ? "" : ",\n",
+			config.m_scenario.c_str(), config.m_net_size, config.m_chain_count, config.m_constrain_loops, config.m_threads,
+			point_count, stick_count, frame_ns.size(),
+			mean_ns, sorted.front(), Percentile(sorted, 50), Percentile(sorted, 90), Percentile(sorted, 99), sorted.back(),
+			mean_ns / point_iterations, point_iterations / (mean_ns * 1.0e-9), 1.0e9 / mean_ns);
+		fflush(stdout);
+	}
+
+	/**
+	 * \brief Reads sweep settings, one bounce,gravity,friction,constrain_loops,substeps[,tear_ratio] row per line
+	 * \param path File to read
+	 * \param out Receives the settings, unparsable lines are skipped
+	 * \return False if the file could not be opened
+	 */
+	bool ReadSweepConfigs(const std::string& path, std::vector<VertletSettings>& out)
+	{
+		std::ifstream file(path);
+
+		if (!file)
+		{
+			return false;
+		}
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			float bounce, gravity, friction;
+			int32_t loops, substeps;
+			float tear_ratio = 0;
+
+			if (sscanf(line.c_str(), "%f,%f,%f,%d,%d,%f", &bounce, &gravity, &friction, &loops, &substeps, &tear_ratio) < 5)
+			{
+				continue;
+			}
+
+			VertletSettings settings;
+			settings.m_bounce = bounce;
+			settings.m_gravity = gravity;
+			settings.m_friction = friction;
+			settings.m_constrain_loops = std::max(1, loops);
+			settings.m_substeps = std::max(1, substeps);
+			settings.m_tear_ratio = tear_ratio;
+			out.push_back(settings);
+		}
+
+		return true;
+	}
+
+	/**
+	 * \brief Runs a parameter sweep over a net and a few chains and writes the summary CSV
+	 * \param argc Number of arguments after "sweep"
+	 * \param argv Arguments after "sweep"
+	 * \return Process exit code
+	 */
+	int RunSweepMode(const int argc, char** argv)
+	{
+		const int32_t frames = argc > 0 ? std::max(1, atoi(argv[0])) : 600;
+		const std::string out_path = argc > 1 ? argv[1] : "sweep.csv";
+		std::vector<VertletSettings> configs;
+
+		if (argc > 2)
+		{
+			if (!ReadSweepConfigs(argv[2], configs))
+			{
+				fprintf(stderr, "could not read %s\n", argv[2]);
+				return 1;
+			}
+		}
+		else
+		{
+			for (const float bounce : { 0.5f, 0.9f })
+			{
+				for (const float gravity : { 0.05f, 0.1f, 0.2f })
+				{
+					for (const float friction : { 0.99f, 0.999f })
+					{
+						for (const int32_t loops : { 1, 3, 8 })
+						{
+							VertletSettings settings;
+							settings.m_bounce = bounce;
+							settings.m_gravity = gravity;
+							settings.m_friction = friction;
+							settings.m_constrain_loops = loops;
+							configs.push_back(settings);
+						}
+					}
+				}
+			}
+		}
+
+		const int32_t screen_width = 1280;
+		const int32_t screen_height = 720;
+
+		auto scene = [](VertletWorld& world)
+		{
+			std::vector<VertletBody*> bodies;
+			CreateNet(bodies, 100, 10, 100, 60, 5);
+			for (int32_t i = 0; i < 4; i++)
+			{
+				CreateChain(700 + i * 120, 50, bodies);
+			}
+			world.AddBodies(bodies);
+		};
+
+		const Clock::time_point start = Clock::now();
+		const std::vector<SweepResult> results = RunSweep(configs, scene, screen_width, screen_height, frames);
+		const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+		if (!WriteSweepCsv(out_path, results))
+		{
+			fprintf(stderr, "could not write %s\n", out_path.c_str());
+			return 1;
+		}
+
+		printf("%zu configurations x %d frames in %.2fs, written to %s\n", configs.size(), frames, seconds, out_path.c_str());
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 1 && std::string(argv[1]) == "sweep")
+	{
+		return RunSweepMode(argc - 2, argv + 2);
+	}
+
+	const int32_t frames = argc > 1 ? std::max(1, atoi(argv[1])) : 100;
+
+	const int32_t hw_threads = std::max(1, static_cast<int32_t>(std::thread::hardware_concurrency()));
+	std::vector<int32_t> thread_counts{ 1 };
+	for (int32_t t = 2; t < hw_threads; t *= 2)
+	{
+		thread_counts.push_back(t);
+	}
+	if (hw_threads > 1)
+	{
+		thread_counts.push_back(hw_threads);
+	}
+
+	std::vector<BenchConfig> configs;
+
+	for (const int32_t size : { 80, 160, 250, 500, 1000 })
+	{
+		for (const int32_t loops : { 1, 3, 8 })
+		{
+			configs.push_back({ "net", size, 0, loops, 1 });
+		}
+	}
+
+	for (const int32_t size : { 500, 1000 })
+	{
+		for (const int32_t threads : thread_counts)
+		{
+			configs.push_back({ "partitioned_net", size, 0, 3, threads });
+		}
+	}
+
+	for (const int32_t chains : { 100, 1000, 10000 })
+	{
+		for (const int32_t loops : { 1, 3, 8 })
+		{
+			for (const int32_t threads : thread_counts)
+			{
+				configs.push_back({ "chains", 0, chains, loops, threads });
+			}
+		}
+	}
+
+	printf("{\n\"real\": \"%s\",\n\"hardware_threads\": %d,\n\"results\": [\n", std::is_same<Real, Fixed>::value ? "fixed" : "float", hw_threads);
+
+	for (size_t i = 0; i < configs.size(); i++)
+	{
+		RunConfig(configs[i], frames, i == 0);
+	}
+
+	printf("\n]\n}\n");
+
+	return 0;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace VertletPhysics
+{
+	/**
+	 * \brief Q16.16 fixed point number, every operation is pure integer math so results are bit identical on any compiler, flag set or platform
+	 */
+	struct Fixed
+	{
+		/* Number of fractional bits */
+		static constexpr int32_t s_frac_bits = 16;
+		/* Raw value of 1.0 */
+		static constexpr int32_t s_one = 1 << s_frac_bits;
+
+		int32_t m_raw;
+
+		constexpr Fixed() : m_raw(0) {}
+		constexpr Fixed(const int value) : m_raw(value * s_one) {}
+		constexpr Fixed(const float value) : m_raw(static_cast<int32_t>(value * s_one + (value >= 0.f ? 0.5f : -0.5f))) {}
+		constexpr Fixed(const double value) : m_raw(static_cast<int32_t>(value * s_one + (value >= 0.0 ? 0.5 : -0.5))) {}
+
+		/**
+		 * \brief Create from an already scaled raw value
+		 * \param raw Q16.16 raw bits
+		 * \return Fixed point value
+		 */
+		static constexpr Fixed FromRaw(const int32_t raw)
+		{
+			Fixed f;
+			f.m_raw = raw;
+			return f;
+		}
+
+		constexpr float ToFloat() const { return static_cast<float>(m_raw) / s_one; }
+
+		constexpr Fixed operator-() const { return FromRaw(-m_raw); }
+
+		friend constexpr Fixed operator+(const Fixed a, const Fixed b) { return FromRaw(a.m_raw + b.m_raw); }
+		friend constexpr Fixed operator-(const Fixed a, const Fixed b) { return FromRaw(a.m_raw - b.m_raw); }
+
+		friend constexpr Fixed operator*(const Fixed a, const Fixed b)
+		{
+			return FromRaw(static_cast<int32_t>((static_cast<int64_t>(a.m_raw) * b.m_raw) >> s_frac_bits));
+		}
+
+		friend constexpr Fixed operator/(const Fixed a, const Fixed b)
+		{
+			// saturate instead of trapping, the float path produces inf here
+			if (b.m_raw == 0)
+			{
+				return FromRaw(a.m_raw >= 0 ? INT32_MAX : INT32_MIN);
+			}
+
+			return FromRaw(static_cast<int32_t>((static_cast<int64_t>(a.m_raw) * s_one) / b.m_raw));
+		}
+
+		Fixed& operator+=(const Fixed o) { return *this = *this + o; }
+		Fixed& operator-=(const Fixed o) { return *this = *this - o; }
+		Fixed& operator*=(const Fixed o) { return *this = *this * o; }
+		Fixed& operator/=(const Fixed o) { return *this = *this / o; }
+
+		friend constexpr bool operator==(const Fixed a, const Fixed b) { return a.m_raw == b.m_raw; }
+		friend constexpr bool operator!=(const Fixed a, const Fixed b) { return a.m_raw != b.m_raw; }
+		friend constexpr bool operator<(const Fixed a, const Fixed b) { return a.m_raw < b.m_raw; }
+		friend constexpr bool operator<=(const Fixed a, const Fixed b) { return a.m_raw <= b.m_raw; }
+		friend constexpr bool operator>(const Fixed a, const Fixed b) { return a.m_raw > b.m_raw; }
+		friend constexpr bool operator>=(const Fixed a, const Fixed b) { return a.m_raw >= b.m_raw; }
+	};
+
+	/**
+	 * \brief Integer square root, rounds down
+	 * \param value Value to root
+	 * \return floor(sqrt(value))
+	 */
+	inline uint64_t ISqrt(uint64_t value)
+	{
+		uint64_t result = 0;
+		uint64_t bit = uint64_t(1) << 62;
+
+		while (bit > value)
+		{
+			bit >>= 2;
+		}
+
+		while (bit != 0)
+		{
+			if (value >= result + bit)
+			{
+				value -= result + bit;
+				result = (result >> 1) + bit;
+			}
+			else
+			{
+				result >>= 1;
+			}
+
+			bit >>= 2;
+		}
+
+		return result;
+	}
+
+	/*
+	 * Scalar helpers, overloaded for float and Fixed so the solver can be written once against VertletPhysics::Real
+	 */
+
+	inline float ToFloat(const float value) { return value; }
+	inline float ToFloat(const Fixed value) { return value.ToFloat(); }
+
+	inline float Abs(const float value) { return std::fabs(value); }
+	inline Fixed Abs(const Fixed value) { return Fixed::FromRaw(value.m_raw < 0 ? -value.m_raw : value.m_raw); }
+
+	inline float Sqrt(const float value) { return std::sqrt(value); }
+
+	inline Fixed Sqrt(const Fixed value)
+	{
+		if (value.m_raw <= 0)
+		{
+			return Fixed();
+		}
+
+		return Fixed::FromRaw(static_cast<int32_t>(ISqrt(static_cast<uint64_t>(value.m_raw) << Fixed::s_frac_bits)));
+	}
+
+	/**
+	 * \brief Length of a 2d vector
+	 * \param dx X component
+	 * \param dy Y component
+	 * \return sqrt(dx * dx + dy * dy)
+	 */
+	inline float Length(const float dx, const float dy) { return std::sqrt(dx * dx + dy * dy); }
+
+	/**
+	 * \brief Length of a 2d vector, the squares are summed in 64 bits as screen sized distances overflow Q16.16
+	 * \param dx X component
+	 * \param dy Y component
+	 * \return sqrt(dx * dx + dy * dy)
+	 */
+	inline Fixed Length(const Fixed dx, const Fixed dy)
+	{
+		const uint64_t x = static_cast<uint64_t>(Abs(dx).m_raw);
+		const uint64_t y = static_cast<uint64_t>(Abs(dy).m_raw);
+
+		return Fixed::FromRaw(static_cast<int32_t>(ISqrt(x * x + y * y)));
+	}
+
+#ifdef VERTLET_FIXED_POINT
+	/* Simulation number type, define VERTLET_FIXED_POINT for bit exact deterministic replays */
+	using Real = Fixed;
+#else
+	/* Simulation number type, define VERTLET_FIXED_POINT for bit exact deterministic replays */
+	using Real = float;
+#endif
+}
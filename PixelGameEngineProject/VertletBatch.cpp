@@ -0,0 +1,665 @@
+#include "VertletBatch.h"
+
+#include <algorithm>
+
+namespace VertletPhysics
+{
+	VertletBatchHandle VertletBatch::Add(std::vector<VertletBody*>& bodies)
+	{
+		const uint32_t base = static_cast<uint32_t>(m_x.size());
+		uint32_t point_count = 0;
+		uint32_t stick_count = 0;
+
+		m_point_index.clear();
+
+		for (const auto* body : bodies)
+		{
+			for (const auto* p : body->m_points)
+			{
+				m_point_index[p] = base + point_count++;
+			}
+
+			stick_count += static_cast<uint32_t>(body->m_sticks.size());
+		}
+
+		// a stick into a body left behind would have nothing to point at
+		for (const auto* body : bodies)
+		{
+			for (const auto* s : body->m_sticks)
+			{
+				if (m_point_index.find(s->m_pa) == m_point_index.end() || m_point_index.find(s->m_pb) == m_point_index.end())
+				{
+					return VertletBatchHandle();
+				}
+			}
+		}
+
+		uint32_t slot;
+
+		if (!m_free_slots.empty())
+		{
+			slot = m_free_slots.back();
+			m_free_slots.pop_back();
+		}
+		else
+		{
+			slot = static_cast<uint32_t>(m_groups.size());
+			m_groups.emplace_back();
+		}
+
+		Group& group = m_groups[slot];
+		group.m_live = true;
+		group.m_first_point = base;
+		group.m_point_count = point_count;
+		group.m_first_stick = static_cast<uint32_t>(m_stick_a.size());
+		group.m_stick_count = stick_count;
+		group.m_first_shape = static_cast<uint32_t>(m_shapes.size());
+		m_order.push_back(slot);
+
+		const size_t points_end = m_x.size() + point_count;
+		m_x.reserve(points_end);
+		m_y.reserve(points_end);
+		m_oldx.reserve(points_end);
+		m_oldy.reserve(points_end);
+		m_radius.reserve(points_end);
+		m_rest_x.reserve(points_end);
+		m_rest_y.reserve(points_end);
+		m_point_flags.reserve(points_end);
+
+		for (const auto* body : bodies)
+		{
+			const auto* shape_body = dynamic_cast<const ShapeMatchBody*>(body);
+			const uint32_t first_point = static_cast<uint32_t>(m_x.size());
+
+			for (const auto* p : body->m_points)
+			{
+				m_x.push_back(p->m_x);
+				m_y.push_back(p->m_y);
+				m_oldx.push_back(p->m_oldx);
+				m_oldy.push_back(p->m_oldy);
+				m_radius.push_back(p->m_radius);
+				m_rest_x.push_back(0);
+				m_rest_y.push_back(0);
+				m_point_flags.push_back(static_cast<uint8_t>((p->m_pinned ? s_point_pinned : 0) | (body->draw_points && p->m_should_draw ? s_point_draw : 0)));
+			}
+
+			// a fresh shape match body rests where it is, as its own constructor assumes
+			if (shape_body && !body->m_points.empty())
+			{
+				m_shapes.push_back({ first_point, static_cast<uint32_t>(body->m_points.size()), shape_body->Stiffness() });
+				CaptureRestShape(m_shapes.back());
+				group.m_shape_count++;
+			}
+
+			for (const auto* s : body->m_sticks)
+			{
+				m_stick_a.push_back(m_point_index[s->m_pa]);
+				m_stick_b.push_back(m_point_index[s->m_pb]);
+				m_stick_length.push_back(s->m_length);
+				m_stick_compliance.push_back(s->m_compliance);
+				m_stick_flags.push_back(static_cast<uint8_t>((s->m_hidden ? s_stick_hidden : 0) | (shape_body ? s_stick_outline : 0)));
+			}
+		}
+
+		for (auto* body : bodies)
+		{
+			delete body;
+		}
+
+		bodies.clear();
+
+		return { slot, group.m_generation };
+	}
+
+	bool VertletBatch::Remove(const VertletBatchHandle handle)
+	{
+		if (!IsValid(handle))
+		{
+			return false;
+		}
+
+		Group& group = m_groups[handle.m_slot];
+		group.m_live = false;
+		group.m_generation++;
+		m_removed++;
+		m_dirty = true;
+		return true;
+	}
+
+	bool VertletBatch::IsValid(const VertletBatchHandle handle) const
+	{
+		return handle.m_slot < m_groups.size() && m_groups[handle.m_slot].m_live && m_groups[handle.m_slot].m_generation == handle.m_generation;
+	}
+
+	bool VertletBatch::PointRange(const VertletBatchHandle handle, uint32_t& out_first, uint32_t& out_count) const
+	{
+		if (!IsValid(handle))
+		{
+			return false;
+		}
+
+		out_first = m_groups[handle.m_slot].m_first_point;
+		out_count = m_groups[handle.m_slot].m_point_count;
+		return true;
+	}
+
+	bool VertletBatch::Translate(const VertletBatchHandle handle, const Real dx, const Real dy)
+	{
+		if (!IsValid(handle))
+		{
+			return false;
+		}
+
+		const Group& group = m_groups[handle.m_slot];
+
+		for (uint32_t i = group.m_first_point; i < group.m_first_point + group.m_point_count; i++)
+		{
+			m_x[i] += dx;
+			m_y[i] += dy;
+			m_oldx[i] += dx;
+			m_oldy[i] += dy;
+		}
+
+		return true;
+	}
+
+	void VertletBatch::Clear()
+	{
+		m_x.clear();
+		m_y.clear();
+		m_oldx.clear();
+		m_oldy.clear();
+		m_radius.clear();
+		m_rest_x.clear();
+		m_rest_y.clear();
+		m_point_flags.clear();
+		m_stick_a.clear();
+		m_stick_b.clear();
+		m_stick_length.clear();
+		m_stick_compliance.clear();
+		m_stick_flags.clear();
+		m_shapes.clear();
+		m_order.clear();
+		m_free_slots.clear();
+		m_removed = 0;
+		m_dirty = false;
+
+		// slots are kept so handles given out before stay invalid
+		for (uint32_t slot = 0; slot < m_groups.size(); slot++)
+		{
+			Group& group = m_groups[slot];
+
+			if (group.m_live)
+			{
+				group.m_live = false;
+				group.m_generation++;
+			}
+
+			m_free_slots.push_back(slot);
+		}
+	}
+
+	void VertletBatch::Update(const int32_t screen_width, const int32_t screen_height, const olc::vf2d mouse_dir, const olc::vf2d mouse_pos, const bool cut_pressed, const VertletSettings& settings)
+	{
+		if (m_dirty)
+		{
+			Compact();
+		}
+
+		if (m_x.empty())
+		{
+			return;
+		}
+
+		VERTLET_PROFILE_COUNT(Points, m_x.size());
+		VERTLET_PROFILE_COUNT(Sticks, m_stick_a.size());
+
+		const int32_t substeps = settings.m_substeps;
+		const Real step_scale = substeps > 1 ? Real(1) / substeps : Real(1);
+		SetStepScale(step_scale);
+
+		const int32_t constrain_loops = settings.m_solver == VertletSolver::Xpbd ? 1 : settings.m_constrain_loops;
+		size_t torn = 0;
+
+		for (int32_t step = 0; step < substeps; step++)
+		{
+			// mouse interaction is a once per frame impulse
+			const bool first_step = step == 0;
+
+			// cut points leave before the solver sees them
+			if (IntegratePoints(mouse_dir, mouse_pos, first_step && cut_pressed, first_step, step_scale, settings))
+			{
+				Compact();
+			}
+
+			for (int32_t i = 1; i <= constrain_loops; i++)
+			{
+				torn += SolveSticks(settings);
+				SolveShapes();
+				ConstrainPoints(screen_width, screen_height, settings);
+			}
+		}
+
+		if (torn > 0)
+		{
+			VERTLET_PROFILE_COUNT(Tears, torn);
+			Compact();
+		}
+	}
+
+	void VertletBatch::WriteSnapshot(VertletSnapshot& out, const bool allow_points) const
+	{
+		for (const uint32_t slot : m_order)
+		{
+			const Group& group = m_groups[slot];
+
+			if (!group.m_live)
+			{
+				continue;
+			}
+
+			if (allow_points)
+			{
+				for (uint32_t i = group.m_first_point; i < group.m_first_point + group.m_point_count; i++)
+				{
+					if (m_point_flags[i] & s_point_draw)
+					{
+						const bool touched = (m_point_flags[i] & s_point_touched) != 0;
+						const auto radius = touched ? m_radius[i] * 3 : m_radius[i];
+						out.m_points.push_back({ ToFloat(m_x[i]), ToFloat(m_y[i]), ToFloat(radius), touched });
+					}
+				}
+			}
+
+			for (uint32_t i = group.m_first_stick; i < group.m_first_stick + group.m_stick_count; i++)
+			{
+				if ((m_stick_flags[i] & s_stick_hidden) == 0)
+				{
+					const uint32_t a = m_stick_a[i];
+					const uint32_t b = m_stick_b[i];
+					out.m_lines.push_back({ static_cast<int32_t>(ToFloat(m_x[a])), static_cast<int32_t>(ToFloat(m_y[a])),
+						static_cast<int32_t>(ToFloat(m_x[b])), static_cast<int32_t>(ToFloat(m_y[b])) });
+				}
+			}
+		}
+	}
+
+	void VertletBatch::SetStepScale(const Real step_scale)
+	{
+		if (step_scale == m_step_scale)
+		{
+			return;
+		}
+
+		// velocity is stored as distance moved per step, rescale it to the new step length
+		const Real ratio = step_scale / m_step_scale;
+
+		for (size_t i = 0; i < m_x.size(); i++)
+		{
+			if ((m_point_flags[i] & s_point_pinned) == 0)
+			{
+				m_oldx[i] = m_x[i] - (m_x[i] - m_oldx[i]) * ratio;
+				m_oldy[i] = m_y[i] - (m_y[i] - m_oldy[i]) * ratio;
+			}
+		}
+
+		m_step_scale = step_scale;
+	}
+
+	bool VertletBatch::IntegratePoints(const olc::vf2d mouse_dir, const olc::vf2d mouse_pos, const bool cut, const bool interact, const Real step_scale, const VertletSettings& settings)
+	{
+		VERTLET_PROFILE_SCOPE(Integrate);
+
+		// forces are per frame, scale them to the step length, matches VertletBody::UpdatePoints
+		const Real gravity = step_scale == Real(1) ? settings.m_gravity : settings.m_gravity * step_scale * step_scale;
+		const Real friction = step_scale == Real(1) ? settings.m_friction : Real(1) - (Real(1) - settings.m_friction) * step_scale;
+
+		if (!interact)
+		{
+			for (size_t i = 0; i < m_x.size(); i++)
+			{
+				if ((m_point_flags[i] & s_point_pinned) == 0)
+				{
+					IntegrateVerlet(m_x[i], m_y[i], m_oldx[i], m_oldy[i], 0, 0, 0, gravity, friction);
+				}
+			}
+
+			return false;
+		}
+
+		const Real mouse_x = Real(mouse_pos.x);
+		const Real mouse_y = Real(mouse_pos.y);
+		const Real mouse_mod_x = Real(mouse_dir.x) * 5 * step_scale;
+		const Real mouse_mod_y = Real(mouse_dir.y) * 5 * step_scale;
+		bool any_cut = false;
+
+		for (size_t i = 0; i < m_x.size(); i++)
+		{
+			uint8_t flags = static_cast<uint8_t>(m_point_flags[i] & ~s_point_touched);
+
+			if (flags & s_point_pinned)
+			{
+				m_point_flags[i] = flags;
+				continue;
+			}
+
+			const bool within = Abs(mouse_x - m_x[i]) <= m_radius[i] * 2 && Abs(mouse_y - m_y[i]) <= m_radius[i] * 2;
+
+			if (within && cut)
+			{
+				VERTLET_PROFILE_COUNT(Cuts, 1);
+				m_point_flags[i] = flags | s_point_cut;
+				any_cut = true;
+				continue;
+			}
+
+			if (within)
+			{
+				flags |= s_point_touched;
+			}
+
+			m_point_flags[i] = flags;
+			IntegrateVerlet(m_x[i], m_y[i], m_oldx[i], m_oldy[i], within ? mouse_mod_x : Real(0), within ? mouse_mod_y : Real(0), 0, gravity, friction);
+		}
+
+		return any_cut;
+	}
+
+	size_t VertletBatch::SolveSticks(const VertletSettings& settings)
+	{
+		VERTLET_PROFILE_SCOPE(Sticks);
+
+		const Real tear_ratio = settings.m_tear_ratio;
+		const bool tearing = tear_ratio > Real(0);
+		const bool xpbd = settings.m_solver == VertletSolver::Xpbd;
+		const Real inv_step_sq = Real(1) / (m_step_scale * m_step_scale);
+		size_t torn = 0;
+
+		for (size_t i = 0; i < m_stick_a.size(); i++)
+		{
+			if (m_stick_flags[i] & (s_stick_outline | s_stick_torn))
+			{
+				continue;
+			}
+
+			const uint32_t a = m_stick_a[i];
+			const uint32_t b = m_stick_b[i];
+
+			const auto dx = m_x[b] - m_x[a];
+			const auto dy = m_y[b] - m_y[a];
+			const auto distance = Length(dx, dy);
+
+			if (tearing && distance > m_stick_length[i] * tear_ratio)
+			{
+				m_stick_flags[i] |= s_stick_torn;
+				torn++;
+				continue;
+			}
+
+			// XPBD as in VertletBody, unit mass points, pinned points have no inverse mass
+			if (xpbd)
+			{
+				const Real weight_a = (m_point_flags[a] & s_point_pinned) ? Real(0) : Real(1);
+				const Real weight_b = (m_point_flags[b] & s_point_pinned) ? Real(0) : Real(1);
+				const Real denominator = weight_a + weight_b + m_stick_compliance[i] * inv_step_sq;
+
+				if (denominator != Real(0))
+				{
+					const auto correction = (distance - m_stick_length[i]) / denominator / distance;
+
+					m_x[a] += dx * correction * weight_a;
+					m_y[a] += dy * correction * weight_a;
+					m_x[b] -= dx * correction * weight_b;
+					m_y[b] -= dy * correction * weight_b;
+				}
+				continue;
+			}
+
+			const auto percent = (m_stick_length[i] - distance) / distance / 2;
+			const auto offset_x = dx * percent;
+			const auto offset_y = dy * percent;
+
+			if ((m_point_flags[a] & s_point_pinned) == 0)
+			{
+				m_x[a] -= offset_x;
+				m_y[a] -= offset_y;
+			}
+
+			if ((m_point_flags[b] & s_point_pinned) == 0)
+			{
+				m_x[b] += offset_x;
+				m_y[b] += offset_y;
+			}
+		}
+
+		return torn;
+	}
+
+	void VertletBatch::SolveShapes()
+	{
+		VERTLET_PROFILE_SCOPE(Sticks);
+
+		// same fit as ShapeMatchBody::SolveConstraints, over a range of the shared arrays
+		for (const Shape& shape : m_shapes)
+		{
+			const uint32_t first = shape.m_first_point;
+			const uint32_t end = first + shape.m_point_count;
+
+			if (shape.m_point_count < 2)
+			{
+				continue;
+			}
+
+			const Real inv_count = Real(1) / static_cast<int>(shape.m_point_count);
+			Real centre_x = 0;
+			Real centre_y = 0;
+
+			for (uint32_t i = first; i < end; i++)
+			{
+				centre_x += m_x[i] * inv_count;
+				centre_y += m_y[i] * inv_count;
+			}
+
+			Real a = 0;
+			Real b = 0;
+
+			for (uint32_t i = first; i < end; i++)
+			{
+				const Real px = m_x[i] - centre_x;
+				const Real py = m_y[i] - centre_y;
+
+				a += (px * m_rest_x[i] + py * m_rest_y[i]) * inv_count;
+				b += (py * m_rest_x[i] - px * m_rest_y[i]) * inv_count;
+			}
+
+			const Real length = Length(a, b);
+
+			if (length == Real(0))
+			{
+				continue;
+			}
+
+			const Real cos_r = a / length;
+			const Real sin_r = b / length;
+
+			for (uint32_t i = first; i < end; i++)
+			{
+				if (m_point_flags[i] & s_point_pinned)
+				{
+					continue;
+				}
+
+				const Real goal_x = centre_x + cos_r * m_rest_x[i] - sin_r * m_rest_y[i];
+				const Real goal_y = centre_y + sin_r * m_rest_x[i] + cos_r * m_rest_y[i];
+
+				m_x[i] += (goal_x - m_x[i]) * shape.m_stiffness;
+				m_y[i] += (goal_y - m_y[i]) * shape.m_stiffness;
+			}
+		}
+	}
+
+	void VertletBatch::ConstrainPoints(const int32_t screen_width, const int32_t screen_height, const VertletSettings& settings)
+	{
+		VERTLET_PROFILE_SCOPE(Bounds);
+
+		for (size_t i = 0; i < m_x.size(); i++)
+		{
+			if ((m_point_flags[i] & s_point_pinned) == 0)
+			{
+				ConstrainToScreen(m_x[i], m_y[i], m_oldx[i], m_oldy[i], m_radius[i], screen_width, screen_height, settings.m_friction, settings.m_bounce);
+			}
+		}
+	}
+
+	void VertletBatch::CaptureRestShape(const Shape& shape)
+	{
+		const uint32_t first = shape.m_first_point;
+		const uint32_t end = first + shape.m_point_count;
+
+		if (shape.m_point_count == 0)
+		{
+			return;
+		}
+
+		const Real inv_count = Real(1) / static_cast<int>(shape.m_point_count);
+		Real centre_x = 0;
+		Real centre_y = 0;
+
+		for (uint32_t i = first; i < end; i++)
+		{
+			centre_x += m_x[i] * inv_count;
+			centre_y += m_y[i] * inv_count;
+		}
+
+		for (uint32_t i = first; i < end; i++)
+		{
+			m_rest_x[i] = m_x[i] - centre_x;
+			m_rest_y[i] = m_y[i] - centre_y;
+		}
+	}
+
+	void VertletBatch::Compact()
+	{
+		m_remap.assign(m_x.size(), UINT32_MAX);
+
+		uint32_t point_write = 0;
+		uint32_t stick_write = 0;
+		uint32_t shape_write = 0;
+		size_t order_write = 0;
+
+		// everything only ever moves towards the front, so the arrays are compacted in place
+		for (const uint32_t slot : m_order)
+		{
+			Group& group = m_groups[slot];
+
+			if (!group.m_live)
+			{
+				m_free_slots.push_back(slot);
+				continue;
+			}
+
+			const uint32_t first_point = point_write;
+
+			for (uint32_t i = group.m_first_point; i < group.m_first_point + group.m_point_count; i++)
+			{
+				if (m_point_flags[i] & s_point_cut)
+				{
+					continue;
+				}
+
+				m_remap[i] = point_write;
+				m_x[point_write] = m_x[i];
+				m_y[point_write] = m_y[i];
+				m_oldx[point_write] = m_oldx[i];
+				m_oldy[point_write] = m_oldy[i];
+				m_radius[point_write] = m_radius[i];
+				m_rest_x[point_write] = m_rest_x[i];
+				m_rest_y[point_write] = m_rest_y[i];
+				m_point_flags[point_write] = m_point_flags[i];
+				point_write++;
+			}
+
+			const uint32_t first_stick = stick_write;
+
+			for (uint32_t i = group.m_first_stick; i < group.m_first_stick + group.m_stick_count; i++)
+			{
+				const uint32_t a = m_remap[m_stick_a[i]];
+				const uint32_t b = m_remap[m_stick_b[i]];
+
+				if ((m_stick_flags[i] & s_stick_torn) || a == UINT32_MAX || b == UINT32_MAX)
+				{
+					continue;
+				}
+
+				m_stick_a[stick_write] = a;
+				m_stick_b[stick_write] = b;
+				m_stick_length[stick_write] = m_stick_length[i];
+				m_stick_compliance[stick_write] = m_stick_compliance[i];
+				m_stick_flags[stick_write] = m_stick_flags[i];
+				stick_write++;
+			}
+
+			const uint32_t first_shape = shape_write;
+
+			for (uint32_t i = group.m_first_shape; i < group.m_first_shape + group.m_shape_count; i++)
+			{
+				const Shape shape = m_shapes[i];
+				uint32_t kept = 0;
+				uint32_t shape_first = UINT32_MAX;
+
+				for (uint32_t p = shape.m_first_point; p < shape.m_first_point + shape.m_point_count; p++)
+				{
+					if (m_remap[p] != UINT32_MAX)
+					{
+						shape_first = std::min(shape_first, m_remap[p]);
+						kept++;
+					}
+				}
+
+				if (kept == 0)
+				{
+					continue;
+				}
+
+				m_shapes[shape_write] = { shape_first, kept, shape.m_stiffness };
+
+				// like a cut shape match body, what is left takes its current pose as the rest shape
+				if (kept != shape.m_point_count)
+				{
+					CaptureRestShape(m_shapes[shape_write]);
+				}
+
+				shape_write++;
+			}
+
+			group.m_first_point = first_point;
+			group.m_point_count = point_write - first_point;
+			group.m_first_stick = first_stick;
+			group.m_stick_count = stick_write - first_stick;
+			group.m_first_shape = first_shape;
+			group.m_shape_count = shape_write - first_shape;
+
+			m_order[order_write++] = slot;
+		}
+
+		m_x.resize(point_write);
+		m_y.resize(point_write);
+		m_oldx.resize(point_write);
+		m_oldy.resize(point_write);
+		m_radius.resize(point_write);
+		m_rest_x.resize(point_write);
+		m_rest_y.resize(point_write);
+		m_point_flags.resize(point_write);
+
+		m_stick_a.resize(stick_write);
+		m_stick_b.resize(stick_write);
+		m_stick_length.resize(stick_write);
+		m_stick_compliance.resize(stick_write);
+		m_stick_flags.resize(stick_write);
+
+		m_shapes.resize(shape_write);
+		m_order.resize(order_write);
+		m_removed = 0;
+		m_dirty = false;
+	}
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "VertletPhysics.h"
+
+namespace VertletPhysics
+{
+	/* Bodies with at most this many points are worth batching, bigger ones amortise their own overhead */
+	const size_t g_batch_max_points = 8;
+
+	/**
+	 * \brief Refers to a group of bodies moved into a VertletBatch, stays valid until the group is removed
+	 */
+	struct VertletBatchHandle
+	{
+		uint32_t m_slot{ UINT32_MAX };
+		uint32_t m_generation{ 0 };
+	};
+
+	/**
+	 * \brief Many small bodies stored and stepped together
+	 *
+	 * Every point and stick of every group lives in shared flat arrays, so a step is one integrate pass, then per
+	 * constrain loop one stick pass, one shape matching pass and one bounds pass over the whole batch, with no
+	 * per body call or allocation. A group's points stay contiguous and in the order they were added, torn sticks
+	 * and cut points are compacted out at the end of the step. Cutting a point removes it along with its sticks
+	 * instead of splitting it. Like the fluid, batched points ignore force fields and are not collided with fluid,
+	 * recorded for rewind or exported.
+	 */
+	class VertletBatch
+	{
+	public:
+		VertletBatch() = default;
+
+		VertletBatch(const VertletBatch&) = delete;
+		VertletBatch& operator=(const VertletBatch&) = delete;
+
+		/**
+		 * \brief Moves bodies into the batch as one group, plain bodies are stick solved and shape match bodies shape matched
+		 * \param bodies Bodies to take, deleted and cleared on success, sticks may link points of any body in the vec
+		 * \return Handle of the group, invalid if a stick reaches a point outside the bodies, which are then left untouched
+		 */
+		VertletBatchHandle Add(std::vector<VertletBody*>& bodies);
+
+		/**
+		 * \brief Drops a group, its points stop drawing at once and leave the arrays on the next update
+		 * \return False if the handle was already invalid
+		 */
+		bool Remove(const VertletBatchHandle handle);
+
+		bool IsValid(const VertletBatchHandle handle) const;
+
+		/**
+		 * \brief Range of a group's points in the position arrays, changes whenever an update compacts the batch
+		 * \param handle Group to look up
+		 * \param out_first Index of the group's first point
+		 * \param out_count Number of points left in the group
+		 * \return False if the handle is invalid
+		 */
+		bool PointRange(const VertletBatchHandle handle, uint32_t& out_first, uint32_t& out_count) const;
+
+		/**
+		 * \brief Moves a group without changing its velocity
+		 * \return False if the handle is invalid
+		 */
+		bool Translate(const VertletBatchHandle handle, const Real dx, const Real dy);
+
+		void Clear();
+
+		size_t GroupCount() const { return m_order.size() - m_removed; }
+		size_t PointCount() const { return m_x.size(); }
+		size_t StickCount() const { return m_stick_a.size(); }
+
+		/* Point state, same meaning as the VertletPoint fields, indexed by PointRange */
+		const std::vector<Real>& X() const { return m_x; }
+		const std::vector<Real>& Y() const { return m_y; }
+		const std::vector<Real>& OldX() const { return m_oldx; }
+		const std::vector<Real>& OldY() const { return m_oldy; }
+
+		/* Stick ends and rest lengths, indices into the point arrays */
+		const std::vector<uint32_t>& StickA() const { return m_stick_a; }
+		const std::vector<uint32_t>& StickB() const { return m_stick_b; }
+		const std::vector<Real>& StickLength() const { return m_stick_length; }
+
+		/**
+		 * \brief Steps every group, same parameters and meaning as VertletBody::Update
+		 */
+		void Update(const int32_t screen_width, const int32_t screen_height, const olc::vf2d mouse_dir, const olc::vf2d mouse_pos, const bool cut_pressed, const VertletSettings& settings);
+
+		/**
+		 * \brief Appends every live group to a snapshot
+		 * \param out Snapshot to append to
+		 * \param allow_points False to skip points even if their body drew them
+		 */
+		void WriteSnapshot(VertletSnapshot& out, const bool allow_points = true) const;
+
+	private:
+		/* Point flags */
+		static constexpr uint8_t s_point_pinned = 1 << 0;
+		static constexpr uint8_t s_point_draw = 1 << 1;
+		static constexpr uint8_t s_point_touched = 1 << 2;
+		static constexpr uint8_t s_point_cut = 1 << 3;
+
+		/* Stick flags */
+		static constexpr uint8_t s_stick_hidden = 1 << 0;
+		/* Outline of a shape match body, drawn but not solved */
+		static constexpr uint8_t s_stick_outline = 1 << 1;
+		static constexpr uint8_t s_stick_torn = 1 << 2;
+
+		/**
+		 * \brief Ranges of one group, sticks and shapes stay contiguous the same way points do
+		 */
+		struct Group
+		{
+			uint32_t m_generation{ 0 };
+			bool m_live{ false };
+			uint32_t m_first_point{ 0 };
+			uint32_t m_point_count{ 0 };
+			uint32_t m_first_stick{ 0 };
+			uint32_t m_stick_count{ 0 };
+			uint32_t m_first_shape{ 0 };
+			uint32_t m_shape_count{ 0 };
+		};
+
+		/**
+		 * \brief Points held to a rest shape, the rest offsets are m_rest_x and m_rest_y over the same range
+		 */
+		struct Shape
+		{
+			uint32_t m_first_point;
+			uint32_t m_point_count;
+			Real m_stiffness;
+		};
+
+		/**
+		 * \brief Changes the step length, rescaling the stored velocity to match
+		 */
+		void SetStepScale(const Real step_scale);
+
+		/**
+		 * \brief Integrates every unpinned point and applies the mouse, cut points are only flagged
+		 * \return True if a point was cut
+		 */
+		bool IntegratePoints(const olc::vf2d mouse_dir, const olc::vf2d mouse_pos, const bool cut, const bool interact, const Real step_scale, const VertletSettings& settings);
+
+		/**
+		 * \brief One pass over every solved stick with the settings' solver, sticks past the tear ratio are flagged and skipped
+		 * \return Number of sticks newly torn
+		 */
+		size_t SolveSticks(const VertletSettings& settings);
+
+		/**
+		 * \brief Moves every shape's points towards their best fit of its rest shape
+		 */
+		void SolveShapes();
+
+		void ConstrainPoints(const int32_t screen_width, const int32_t screen_height, const VertletSettings& settings);
+
+		/**
+		 * \brief Takes a shape's current positions as its rest shape
+		 */
+		void CaptureRestShape(const Shape& shape);
+
+		/**
+		 * \brief Drops removed groups, cut points, torn sticks and sticks of cut points, keeping everything else in order
+		 */
+		void Compact();
+
+		/* Point state */
+		std::vector<Real> m_x;
+		std::vector<Real> m_y;
+		std::vector<Real> m_oldx;
+		std::vector<Real> m_oldy;
+		std::vector<Real> m_radius;
+		std::vector<Real> m_rest_x;
+		std::vector<Real> m_rest_y;
+		std::vector<uint8_t> m_point_flags;
+
+		/* Stick state */
+		std::vector<uint32_t> m_stick_a;
+		std::vector<uint32_t> m_stick_b;
+		std::vector<Real> m_stick_length;
+		std::vector<Real> m_stick_compliance;
+		std::vector<uint8_t> m_stick_flags;
+
+		std::vector<Shape> m_shapes;
+
+		/* Indexed by handle slot */
+		std::vector<Group> m_groups;
+		/* Slots in storage order, removed ones included until the next compaction */
+		std::vector<uint32_t> m_order;
+		/* Removed slots still in m_order, only reused once compacted away */
+		size_t m_removed{ 0 };
+		std::vector<uint32_t> m_free_slots;
+		/* Set by anything Compact has to clean up */
+		bool m_dirty{ false };
+
+		/* Length of the last step in frames, velocity is stored relative to it */
+		Real m_step_scale{ 1 };
+
+		/* Reused by Add and Compact */
+		std::unordered_map<const VertletPoint*, uint32_t> m_point_index;
+		std::vector<uint32_t> m_remap;
+	};
+}
@@ -0,0 +1,74 @@
+#include "VertletBuilder.h"
+
+namespace VertletPhysics
+{
+	AsyncBodyBuilder::~AsyncBodyBuilder()
+	{
+		Discard();
+		ReapDiscarded(true);
+	}
+
+	void AsyncBodyBuilder::Discard()
+	{
+		for (auto& build : m_pending)
+		{
+			m_discarded.push_back(std::move(build));
+		}
+
+		m_pending.clear();
+	}
+
+	void AsyncBodyBuilder::ReapDiscarded(const bool wait)
+	{
+		for (auto it = m_discarded.begin(); it != m_discarded.end();)
+		{
+			if (!wait && it->wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				++it;
+				continue;
+			}
+
+			for (auto* body : it->get())
+			{
+				delete body;
+			}
+
+			it = m_discarded.erase(it);
+		}
+	}
+
+	void AsyncBodyBuilder::Build(Factory factory)
+	{
+		m_pending.emplace_back(std::async(std::launch::async, [factory]()
+		{
+			std::vector<VertletBody*> bodies;
+			factory(bodies);
+			return bodies;
+		}));
+	}
+
+	size_t AsyncBodyBuilder::Publish(std::vector<VertletBody*>& out_bodies)
+	{
+		ReapDiscarded(false);
+
+		size_t published = 0;
+
+		for (auto it = m_pending.begin(); it != m_pending.end();)
+		{
+			if (it->wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				++it;
+				continue;
+			}
+
+			// bodies are fully constructed by the worker, hand them over in one step
+			const std::vector<VertletBody*> bodies = it->get();
+			out_bodies.insert(out_bodies.end(), bodies.begin(), bodies.end());
+			published += bodies.size();
+
+			it = m_pending.erase(it);
+		}
+
+		return published;
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <vector>
+#include "VertletPhysics.h"
+
+namespace VertletPhysics
+{
+	/**
+	 * \brief Runs body factories such as CreateNet on worker threads so large bodies can be spawned without stalling a frame
+	 */
+	class AsyncBodyBuilder
+	{
+	public:
+		/* Factory that appends new bodies to the vector, e.g. a lambda around CreateNet */
+		using Factory = std::function<bool(std::vector<VertletBody*>&)>;
+
+		AsyncBodyBuilder() = default;
+		AsyncBodyBuilder(const AsyncBodyBuilder&) = delete;
+		AsyncBodyBuilder& operator=(const AsyncBodyBuilder&) = delete;
+
+		/**
+		 * \brief Waits for outstanding builds and deletes bodies that were never published or were discarded
+		 */
+		~AsyncBodyBuilder();
+
+		/**
+		 * \brief Starts building bodies on a worker thread
+		 * \param factory Function that creates the bodies
+		 */
+		void Build(Factory factory);
+
+		/**
+		 * \brief Moves every finished build into out_bodies, never blocks
+		 * \param out_bodies Vec the finished bodies are appended to
+		 * \return Number of bodies published
+		 */
+		size_t Publish(std::vector<VertletBody*>& out_bodies);
+
+		/**
+		 * \brief Drops every build started so far, they are never published and their bodies are deleted once done, never blocks
+		 */
+		void Discard();
+
+		/**
+		 * \brief Number of builds that have not been published yet
+		 */
+		size_t Pending() const { return m_pending.size(); }
+
+	private:
+		/**
+		 * \brief Deletes the bodies of discarded builds that have finished
+		 * \param wait True to wait for the ones still running
+		 */
+		void ReapDiscarded(const bool wait);
+
+		std::vector<std::future<std::vector<VertletBody*>>> m_pending;
+		/* Builds dropped by Discard, kept until they finish as destroying an async future would block */
+		std::vector<std::future<std::vector<VertletBody*>>> m_discarded;
+	};
+}
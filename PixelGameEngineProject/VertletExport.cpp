@@ -0,0 +1,489 @@
+#include "VertletExport.h"
+
+#include <algorithm>
+#include <cerrno>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace VertletPhysics
+{
+	/* Attempts ReadLatest makes before giving up on a writer that keeps overtaking it */
+	static constexpr int32_t s_read_attempts = 8;
+
+	static size_t AlignCacheLine(const size_t bytes)
+	{
+		return (bytes + 63) & ~size_t(63);
+	}
+
+	static std::string PlatformName(const std::string& name)
+	{
+#ifdef _WIN32
+		return "Local\\" + name;
+#else
+		return "/" + name;
+#endif
+	}
+
+	static uint32_t CurrentProcessId()
+	{
+#ifdef _WIN32
+		return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+		return static_cast<uint32_t>(getpid());
+#endif
+	}
+
+#ifndef _WIN32
+	/**
+	 * \brief Whether an existing object was left behind by an exporter that is no longer running
+	 *
+	 * An object without the magic is still being set up by its creator and counts as live. One with the magic but no
+	 * owner was written before owners were recorded and counts as abandoned.
+	 */
+	static bool RegionAbandoned(const std::string& name)
+	{
+		const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+
+		if (fd < 0)
+		{
+			// removed since, nothing left to replace
+			return errno == ENOENT;
+		}
+
+		struct stat info{};
+		bool abandoned = false;
+
+		if (fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(SharedExportHeader)))
+		{
+			void* memory = mmap(nullptr, sizeof(SharedExportHeader), PROT_READ, MAP_SHARED, fd, 0);
+
+			if (memory != MAP_FAILED)
+			{
+				const auto* header = static_cast<const SharedExportHeader*>(memory);
+				const pid_t owner = static_cast<pid_t>(header->m_owner_pid);
+
+				abandoned = header->m_magic == g_export_magic && (owner == 0 || (kill(owner, 0) != 0 && errno == ESRCH));
+				munmap(memory, sizeof(SharedExportHeader));
+			}
+		}
+
+		close(fd);
+		return abandoned;
+	}
+#endif
+
+	/**
+	 * \brief Creates a shared object of the given size and maps it read write, replacing a stale object of the same name
+	 * \return Mapped memory or null, also null if a running process owns the name
+	 */
+	static uint8_t* CreateRegion(const std::string& name, const size_t bytes, intptr_t& out_handle)
+	{
+#ifdef _WIN32
+		const uint64_t size = bytes;
+		HANDLE handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), name.c_str());
+
+		if (handle == nullptr)
+		{
+			return nullptr;
+		}
+
+		// named mappings go away with their last handle, so an existing one belongs to a running process
+		if (GetLastError() == ERROR_ALREADY_EXISTS)
+		{
+			CloseHandle(handle);
+			return nullptr;
+		}
+
+		void* memory = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+
+		if (memory == nullptr)
+		{
+			CloseHandle(handle);
+			return nullptr;
+		}
+
+		out_handle = reinterpret_cast<intptr_t>(handle);
+		return static_cast<uint8_t*>(memory);
+#else
+		int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+		// a region left behind by a crashed run may have another size or layout, replace it
+		if (fd < 0 && errno == EEXIST && RegionAbandoned(name))
+		{
+			shm_unlink(name.c_str());
+			fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+		}
+
+		if (fd < 0)
+		{
+			return nullptr;
+		}
+
+		if (ftruncate(fd, static_cast<off_t>(bytes)) != 0)
+		{
+			close(fd);
+			shm_unlink(name.c_str());
+			return nullptr;
+		}
+
+		void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+		if (memory == MAP_FAILED)
+		{
+			close(fd);
+			shm_unlink(name.c_str());
+			return nullptr;
+		}
+
+		out_handle = fd;
+		return static_cast<uint8_t*>(memory);
+#endif
+	}
+
+	/**
+	 * \brief Maps an existing shared object read only
+	 * \return Mapped memory or null
+	 */
+	static const uint8_t* OpenRegion(const std::string& name, size_t& out_bytes, intptr_t& out_handle)
+	{
+#ifdef _WIN32
+		HANDLE handle = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+
+		if (handle == nullptr)
+		{
+			return nullptr;
+		}
+
+		void* memory = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+
+		if (memory == nullptr)
+		{
+			CloseHandle(handle);
+			return nullptr;
+		}
+
+		MEMORY_BASIC_INFORMATION info{};
+		VirtualQuery(memory, &info, sizeof(info));
+
+		out_bytes = info.RegionSize;
+		out_handle = reinterpret_cast<intptr_t>(handle);
+		return static_cast<const uint8_t*>(memory);
+#else
+		const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+
+		if (fd < 0)
+		{
+			return nullptr;
+		}
+
+		struct stat info{};
+
+		if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(SharedExportHeader)))
+		{
+			close(fd);
+			return nullptr;
+		}
+
+		void* memory = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+
+		if (memory == MAP_FAILED)
+		{
+			close(fd);
+			return nullptr;
+		}
+
+		out_bytes = static_cast<size_t>(info.st_size);
+		out_handle = fd;
+		return static_cast<const uint8_t*>(memory);
+#endif
+	}
+
+	static void CloseRegion(const void* memory, const size_t bytes, const intptr_t handle)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(memory);
+		CloseHandle(reinterpret_cast<HANDLE>(handle));
+#else
+		munmap(const_cast<void*>(memory), bytes);
+		close(static_cast<int>(handle));
+#endif
+	}
+
+	/**
+	 * \brief Marks a block as being written, readers that started before now will retry
+	 */
+	static void BeginWrite(std::atomic<uint64_t>& seq)
+	{
+		seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	static void EndWrite(std::atomic<uint64_t>& seq)
+	{
+		seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	VertletSharedExport::VertletSharedExport(const uint32_t max_points, const uint32_t max_sticks) :
+		m_max_points(max_points),
+		m_max_sticks(max_sticks)
+	{
+	}
+
+	VertletSharedExport::~VertletSharedExport()
+	{
+		if (m_region == nullptr)
+		{
+			return;
+		}
+
+		CloseRegion(m_region, m_region_bytes, m_handle);
+#ifndef _WIN32
+		shm_unlink(m_name.c_str());
+#endif
+	}
+
+	bool VertletSharedExport::Open(const std::string& name)
+	{
+		if (m_region != nullptr)
+		{
+			return true;
+		}
+
+		const size_t topology_offset = AlignCacheLine(sizeof(SharedExportHeader));
+		const size_t slots_offset = topology_offset + AlignCacheLine(sizeof(SharedExportTopology) + size_t(m_max_sticks) * 2 * sizeof(uint32_t));
+
+		m_slot_bytes = AlignCacheLine(sizeof(SharedExportFrame) + size_t(m_max_points) * 2 * sizeof(float));
+		m_region_bytes = slots_offset + m_slot_bytes * g_export_slots;
+		m_name = PlatformName(name);
+		m_region = CreateRegion(m_name, m_region_bytes, m_handle);
+
+		if (m_region == nullptr)
+		{
+			m_region_bytes = 0;
+			return false;
+		}
+
+		// the object starts zero filled, so every sequence counter is even and nothing is published
+		auto* header = reinterpret_cast<SharedExportHeader*>(m_region);
+		header->m_version = g_export_version;
+		header->m_slot_count = g_export_slots;
+		header->m_max_points = m_max_points;
+		header->m_max_sticks = m_max_sticks;
+		header->m_owner_pid = CurrentProcessId();
+		header->m_topology_offset = topology_offset;
+		header->m_slots_offset = slots_offset;
+		header->m_slot_bytes = m_slot_bytes;
+
+		// readers check the magic last so they never see a half written header
+		std::atomic_thread_fence(std::memory_order_release);
+		header->m_magic = g_export_magic;
+
+		return true;
+	}
+
+	SharedExportFrame* VertletSharedExport::Slot(const uint64_t index) const
+	{
+		const auto* header = reinterpret_cast<const SharedExportHeader*>(m_region);
+		return reinterpret_cast<SharedExportFrame*>(m_region + header->m_slots_offset + (index % g_export_slots) * m_slot_bytes);
+	}
+
+	void VertletSharedExport::Publish(const std::vector<VertletBody*>& bodies, const uint64_t step, const bool topology_changed)
+	{
+		if (m_region == nullptr)
+		{
+			return;
+		}
+
+		if (topology_changed || m_published == 0)
+		{
+			PublishTopology(bodies);
+		}
+
+		SharedExportFrame* frame = Slot(m_published);
+		auto* positions = reinterpret_cast<float*>(frame + 1);
+		uint32_t count = 0;
+		bool truncated = false;
+
+		BeginWrite(frame->m_seq);
+
+		for (const auto* body : bodies)
+		{
+			for (const auto* p : body->m_points)
+			{
+				if (count == m_max_points)
+				{
+					truncated = true;
+					break;
+				}
+
+				positions[count * 2] = ToFloat(p->m_x);
+				positions[count * 2 + 1] = ToFloat(p->m_y);
+				count++;
+			}
+		}
+
+		frame->m_step = step;
+		frame->m_topology = m_topology;
+		frame->m_point_count = count;
+		frame->m_truncated = truncated ? 1 : 0;
+
+		EndWrite(frame->m_seq);
+
+		m_published++;
+		reinterpret_cast<SharedExportHeader*>(m_region)->m_published.store(m_published, std::memory_order_release);
+	}
+
+	void VertletSharedExport::PublishTopology(const std::vector<VertletBody*>& bodies)
+	{
+		auto* header = reinterpret_cast<SharedExportHeader*>(m_region);
+		auto* topology = reinterpret_cast<SharedExportTopology*>(m_region + header->m_topology_offset);
+		auto* sticks = reinterpret_cast<uint32_t*>(topology + 1);
+
+		// index points in the order Publish writes them, sticks may join points of different bodies
+		m_point_index.clear();
+
+		for (const auto* body : bodies)
+		{
+			for (const auto* p : body->m_points)
+			{
+				if (m_point_index.size() == m_max_points)
+				{
+					break;
+				}
+
+				m_point_index.emplace(p, static_cast<uint32_t>(m_point_index.size()));
+			}
+		}
+
+		uint32_t count = 0;
+
+		m_topology++;
+		BeginWrite(topology->m_seq);
+
+		for (const auto* body : bodies)
+		{
+			for (const auto* s : body->m_sticks)
+			{
+				const auto a = m_point_index.find(s->m_pa);
+				const auto b = m_point_index.find(s->m_pb);
+
+				// sticks to points past the capacity are left out with them
+				if (a == m_point_index.end() || b == m_point_index.end() || count == m_max_sticks)
+				{
+					continue;
+				}
+
+				sticks[count * 2] = a->second;
+				sticks[count * 2 + 1] = b->second;
+				count++;
+			}
+		}
+
+		topology->m_topology = m_topology;
+		topology->m_point_count = static_cast<uint32_t>(m_point_index.size());
+		topology->m_stick_count = count;
+
+		EndWrite(topology->m_seq);
+	}
+
+	VertletSharedReader::~VertletSharedReader()
+	{
+		if (m_region != nullptr)
+		{
+			CloseRegion(m_region, m_region_bytes, m_handle);
+		}
+	}
+
+	bool VertletSharedReader::Open(const std::string& name)
+	{
+		if (m_region != nullptr)
+		{
+			return true;
+		}
+
+		m_region = OpenRegion(PlatformName(name), m_region_bytes, m_handle);
+
+		if (m_region == nullptr)
+		{
+			return false;
+		}
+
+		const SharedExportHeader* header = Header();
+
+		if (header->m_magic != g_export_magic || header->m_version != g_export_version ||
+			header->m_slots_offset + header->m_slot_bytes * header->m_slot_count > m_region_bytes)
+		{
+			CloseRegion(m_region, m_region_bytes, m_handle);
+			m_region = nullptr;
+			return false;
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return true;
+	}
+
+	bool VertletSharedReader::ReadLatest(std::vector<float>& out_positions, std::vector<uint32_t>& out_sticks, uint64_t& out_step) const
+	{
+		if (m_region == nullptr)
+		{
+			return false;
+		}
+
+		const SharedExportHeader* header = Header();
+		const auto* topology = reinterpret_cast<const SharedExportTopology*>(m_region + header->m_topology_offset);
+
+		for (int32_t attempt = 0; attempt < s_read_attempts; attempt++)
+		{
+			const uint64_t published = header->m_published.load(std::memory_order_acquire);
+
+			if (published == 0)
+			{
+				return false;
+			}
+
+			const auto* frame = reinterpret_cast<const SharedExportFrame*>(m_region + header->m_slots_offset + ((published - 1) % header->m_slot_count) * header->m_slot_bytes);
+
+			const uint64_t frame_seq = frame->m_seq.load(std::memory_order_acquire);
+			const uint32_t point_count = std::min(frame->m_point_count, header->m_max_points);
+			const uint64_t frame_topology = frame->m_topology;
+			out_step = frame->m_step;
+			out_positions.assign(frame->Positions(), frame->Positions() + size_t(point_count) * 2);
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			// the writer wrapped around the ring onto this slot while it was copied
+			if ((frame_seq & 1) != 0 || frame->m_seq.load(std::memory_order_relaxed) != frame_seq)
+			{
+				continue;
+			}
+
+			const uint64_t topology_seq = topology->m_seq.load(std::memory_order_acquire);
+			const uint32_t stick_count = std::min(topology->m_stick_count, header->m_max_sticks);
+			const uint64_t topology_id = topology->m_topology;
+			out_sticks.assign(topology->Sticks(), topology->Sticks() + size_t(stick_count) * 2);
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			if ((topology_seq & 1) != 0 || topology->m_seq.load(std::memory_order_relaxed) != topology_seq)
+			{
+				continue;
+			}
+
+			// the topology moved on after the frame was written, a newer frame uses it
+			if (topology_id == frame_topology)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
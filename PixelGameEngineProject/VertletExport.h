@@ -0,0 +1,197 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "VertletPhysics.h"
+
+/*
+ * Shared memory export of the simulation state
+ *
+ * The region starts with a SharedExportHeader, followed by one SharedExportTopology block and a ring of
+ * SharedExportFrame slots. Frames hold the point positions of one step and the topology block holds the sticks
+ * as pairs of indices into a frame's points. Every block is guarded by its own sequence counter, odd while the
+ * block is being written, so a reader copies or reads a block in place and retries if the counter moved.
+ *
+ * To read the newest state: load m_published from the header, read slot (m_published - 1) % m_slot_count, and if
+ * its m_topology differs from the topology block's, read the topology block again. A topology newer than the
+ * frame means a newer frame is on its way, retry from m_published.
+ *
+ * Only bodies are exported, points in a VertletBatch and fluid particles are left out. A name belongs to one
+ * process at a time, a second exporter under the same name fails to open instead of taking over the region.
+ */
+
+namespace VertletPhysics
+{
+	/* Shared memory object name, "/vertlet_scene" on POSIX, "Local\vertlet_scene" on Windows */
+	const char* const g_export_name = "vertlet_scene";
+	/* Frame slots in the ring, a reader has this many steps to finish reading a frame */
+	const uint32_t g_export_slots = 4;
+	/* Capacity of the region, extra points and sticks are left out and the frame is flagged */
+	const uint32_t g_export_max_points = 1 << 16;
+	const uint32_t g_export_max_sticks = 1 << 17;
+
+	/* "VRLT" */
+	const uint32_t g_export_magic = 0x544c5256;
+	/* Bumped whenever the layout changes */
+	const uint32_t g_export_version = 1;
+
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared memory export needs address free 64 bit atomics");
+
+	/**
+	 * \brief Start of the shared region, written once when the region is created except for m_published
+	 */
+	struct SharedExportHeader
+	{
+		uint32_t m_magic;
+		uint32_t m_version;
+		uint32_t m_slot_count;
+		uint32_t m_max_points;
+		uint32_t m_max_sticks;
+		/* Process that created the region, lets a later exporter tell a region left by a crash from a live one */
+		uint32_t m_owner_pid;
+		/* Offsets from the start of the region */
+		uint64_t m_topology_offset;
+		uint64_t m_slots_offset;
+		uint64_t m_slot_bytes;
+		/* Frames published so far, the newest is in slot (m_published - 1) % m_slot_count */
+		std::atomic<uint64_t> m_published;
+	};
+
+	/**
+	 * \brief Positions of one step, followed by m_point_count x, y float pairs
+	 */
+	struct SharedExportFrame
+	{
+		/* Odd while the slot is being written */
+		std::atomic<uint64_t> m_seq;
+		uint64_t m_step;
+		/* Topology the point order belongs to, see SharedExportTopology::m_topology */
+		uint64_t m_topology;
+		uint32_t m_point_count;
+		/* Non zero if the scene had more points than m_max_points */
+		uint32_t m_truncated;
+
+		const float* Positions() const { return reinterpret_cast<const float*>(this + 1); }
+	};
+
+	/**
+	 * \brief Stick topology, followed by m_stick_count a, b uint32 index pairs
+	 */
+	struct SharedExportTopology
+	{
+		/* Odd while the block is being written */
+		std::atomic<uint64_t> m_seq;
+		/* Increases whenever points or sticks are added, removed or reordered */
+		uint64_t m_topology;
+		uint32_t m_point_count;
+		uint32_t m_stick_count;
+
+		const uint32_t* Sticks() const { return reinterpret_cast<const uint32_t*>(this + 1); }
+	};
+
+	/**
+	 * \brief Publishes point positions every step and stick topology when it changes into a named shared memory ring
+	 */
+	class VertletSharedExport
+	{
+	public:
+		/**
+		 * \param max_points Points per frame the region has room for
+		 * \param max_sticks Sticks the region has room for
+		 */
+		explicit VertletSharedExport(const uint32_t max_points = g_export_max_points, const uint32_t max_sticks = g_export_max_sticks);
+
+		VertletSharedExport(const VertletSharedExport&) = delete;
+		VertletSharedExport& operator=(const VertletSharedExport&) = delete;
+
+		/* Unmaps and removes the shared object */
+		~VertletSharedExport();
+
+		/**
+		 * \brief Creates the shared object and writes the header, an object of the same name left by a process that
+		 * has exited is replaced but one owned by a running process is not
+		 * \param name Object name without a platform prefix
+		 * \return False if the name is in use or the object could not be created or mapped, Publish then does nothing
+		 */
+		bool Open(const std::string& name = g_export_name);
+
+		bool IsOpen() const { return m_region != nullptr; }
+
+		/**
+		 * \brief Writes the bodies' positions into the next slot, and their sticks first if the topology changed
+		 * \param bodies Bodies to publish
+		 * \param step Step number of this state
+		 * \param topology_changed True if points or sticks were added or removed since the last call
+		 */
+		void Publish(const std::vector<VertletBody*>& bodies, const uint64_t step, const bool topology_changed);
+
+		/* Bytes mapped */
+		size_t RegionBytes() const { return m_region_bytes; }
+
+	private:
+		/**
+		 * \brief Rewrites the topology block from the bodies' sticks
+		 */
+		void PublishTopology(const std::vector<VertletBody*>& bodies);
+
+		SharedExportFrame* Slot(const uint64_t index) const;
+
+		const uint32_t m_max_points;
+		const uint32_t m_max_sticks;
+
+		std::string m_name;
+		uint8_t* m_region{ nullptr };
+		size_t m_region_bytes{ 0 };
+		size_t m_slot_bytes{ 0 };
+		/* Platform handle, a file descriptor on POSIX, a file mapping handle on Windows */
+		intptr_t m_handle{ -1 };
+
+		uint64_t m_topology{ 0 };
+		uint64_t m_published{ 0 };
+
+		/* Reused by PublishTopology */
+		std::unordered_map<const VertletPoint*, uint32_t> m_point_index;
+	};
+
+	/**
+	 * \brief Maps a region written by VertletSharedExport read only, for tools running in another process
+	 */
+	class VertletSharedReader
+	{
+	public:
+		VertletSharedReader() = default;
+
+		VertletSharedReader(const VertletSharedReader&) = delete;
+		VertletSharedReader& operator=(const VertletSharedReader&) = delete;
+
+		~VertletSharedReader();
+
+		/**
+		 * \brief Maps an existing region
+		 * \param name Object name without a platform prefix
+		 * \return False if no region of a matching version exists
+		 */
+		bool Open(const std::string& name = g_export_name);
+
+		/**
+		 * \brief Copies the newest consistent frame and its sticks
+		 * \param out_positions Receives x, y pairs
+		 * \param out_sticks Receives a, b index pairs into out_positions
+		 * \param out_step Receives the frame's step
+		 * \return False if nothing is published yet or the writer kept overtaking the read
+		 */
+		bool ReadLatest(std::vector<float>& out_positions, std::vector<uint32_t>& out_sticks, uint64_t& out_step) const;
+
+		/* Header of the mapped region, for reading in place, null if not open */
+		const SharedExportHeader* Header() const { return reinterpret_cast<const SharedExportHeader*>(m_region); }
+
+	private:
+		const uint8_t* m_region{ nullptr };
+		size_t m_region_bytes{ 0 };
+		intptr_t m_handle{ -1 };
+	};
+}
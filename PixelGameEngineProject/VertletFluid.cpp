@@ -0,0 +1,357 @@
+#include "VertletFluid.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace VertletPhysics
+{
+	/* Particles per chunk handed to a pool thread */
+	static const size_t s_fluid_grain = 1024;
+
+	/**
+	 * \brief Reorders values so out[k] = values[order[k]]
+	 */
+	static void Permute(std::vector<Real>& values, const std::vector<uint32_t>& order, std::vector<Real>& scratch)
+	{
+		scratch.resize(values.size());
+
+		for (size_t k = 0; k < order.size(); k++)
+		{
+			scratch[k] = values[order[k]];
+		}
+
+		values.swap(scratch);
+	}
+
+	VertletFluid::VertletFluid(const FluidSettings& settings) :
+		m_settings(settings)
+	{
+	}
+
+	VertletFluid::~VertletFluid() = default;
+
+	void VertletFluid::AddParticle(const Real x, const Real y)
+	{
+		m_x.push_back(x);
+		m_y.push_back(y);
+		m_oldx.push_back(x);
+		m_oldy.push_back(y);
+	}
+
+	void VertletFluid::AddBlock(const Real x, const Real y, const int32_t columns, const int32_t rows, const Real spacing)
+	{
+		const size_t count = static_cast<size_t>(std::max(0, columns)) * std::max(0, rows);
+
+		m_x.reserve(m_x.size() + count);
+		m_y.reserve(m_y.size() + count);
+		m_oldx.reserve(m_oldx.size() + count);
+		m_oldy.reserve(m_oldy.size() + count);
+
+		for (int32_t row = 0; row < rows; row++)
+		{
+			for (int32_t column = 0; column < columns; column++)
+			{
+				AddParticle(x + spacing * column, y + spacing * row);
+			}
+		}
+	}
+
+	void VertletFluid::Clear()
+	{
+		m_x.clear();
+		m_y.clear();
+		m_oldx.clear();
+		m_oldy.clear();
+	}
+
+	void VertletFluid::Update(const int32_t screen_width, const int32_t screen_height, const VertletSettings& settings, const std::vector<VertletBody*>& bodies)
+	{
+		const size_t count = Size();
+
+		if (count == 0)
+		{
+			return;
+		}
+
+		VERTLET_PROFILE_SCOPE(Fluid);
+
+		if (!m_pool)
+		{
+			m_pool = std::make_unique<ParallelPool>();
+		}
+
+		// same step as the body points, forces are per frame and particles are never pinned
+		m_pool->For(count, s_fluid_grain, [&](const size_t begin, const size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				IntegrateVerlet(m_x[i], m_y[i], m_oldx[i], m_oldy[i], 0, 0, 0, settings.m_gravity, settings.m_friction);
+			}
+		});
+
+		SortIntoGrid(screen_width, screen_height);
+
+		m_pressure.resize(count);
+		m_near_pressure.resize(count);
+		m_dx.resize(count);
+		m_dy.resize(count);
+		m_neighbours.resize(count * g_fluid_max_neighbours);
+		m_neighbour_count.resize(count);
+
+		m_pool->For(count, s_fluid_grain, [this](const size_t begin, const size_t end) { FindNeighbours(begin, end); });
+		m_pool->For(count, s_fluid_grain, [this](const size_t begin, const size_t end) { Relax(begin, end); });
+
+		// displacements were all computed from the same positions, apply them together
+		m_pool->For(count, s_fluid_grain, [this](const size_t begin, const size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				m_x[i] += Real(m_dx[i]);
+				m_y[i] += Real(m_dy[i]);
+			}
+		});
+
+		CollideBodies(bodies);
+
+		const Real radius = m_settings.m_particle_radius;
+
+		m_pool->For(count, s_fluid_grain, [&](const size_t begin, const size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				ConstrainToScreen(m_x[i], m_y[i], m_oldx[i], m_oldy[i], radius, screen_width, screen_height, settings.m_friction, settings.m_bounce);
+			}
+		});
+	}
+
+	void VertletFluid::WriteSnapshot(VertletSnapshot& out) const
+	{
+		out.m_particles.reserve(out.m_particles.size() + Size());
+
+		for (size_t i = 0; i < Size(); i++)
+		{
+			out.m_particles.push_back({ ToFloat(m_x[i]), ToFloat(m_y[i]) });
+		}
+	}
+
+	int32_t VertletFluid::CellOf(const float x, const float y) const
+	{
+		const float inv_cell = 1.f / m_settings.m_interaction_radius;
+		const int32_t cx = std::min(std::max(static_cast<int32_t>(x * inv_cell), 0), m_grid_width - 1);
+		const int32_t cy = std::min(std::max(static_cast<int32_t>(y * inv_cell), 0), m_grid_height - 1);
+
+		return cy * m_grid_width + cx;
+	}
+
+	void VertletFluid::SortIntoGrid(const int32_t screen_width, const int32_t screen_height)
+	{
+		const size_t count = Size();
+		const float cell_size = m_settings.m_interaction_radius;
+
+		m_grid_width = std::max(1, static_cast<int32_t>(std::ceil(screen_width / cell_size)));
+		m_grid_height = std::max(1, static_cast<int32_t>(std::ceil(screen_height / cell_size)));
+
+		const size_t cells = static_cast<size_t>(m_grid_width) * m_grid_height;
+
+		// count particles per cell
+		m_cell_start.assign(cells + 1, 0);
+		m_cell.resize(count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			m_cell[i] = CellOf(ToFloat(m_x[i]), ToFloat(m_y[i]));
+			m_cell_start[m_cell[i] + 1]++;
+		}
+
+		for (size_t c = 0; c < cells; c++)
+		{
+			m_cell_start[c + 1] += m_cell_start[c];
+		}
+
+		// stable scatter, particles keep their relative order within a cell
+		m_cell_cursor.assign(m_cell_start.begin(), m_cell_start.end() - 1);
+		m_order.resize(count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			m_order[m_cell_cursor[m_cell[i]]++] = static_cast<uint32_t>(i);
+		}
+
+		Permute(m_x, m_order, m_sort_scratch);
+		Permute(m_y, m_order, m_sort_scratch);
+		Permute(m_oldx, m_order, m_sort_scratch);
+		Permute(m_oldy, m_order, m_sort_scratch);
+	}
+
+	void VertletFluid::FindNeighbours(const size_t begin, const size_t end)
+	{
+		const float radius = m_settings.m_interaction_radius;
+		const float radius_sq = radius * radius;
+		const float inv_radius = 1.f / radius;
+
+		for (size_t i = begin; i < end; i++)
+		{
+			const float xi = ToFloat(m_x[i]);
+			const float yi = ToFloat(m_y[i]);
+			const int32_t cell = CellOf(xi, yi);
+			const int32_t cx = cell % m_grid_width;
+			const int32_t cy = cell / m_grid_width;
+
+			uint32_t* neighbours = &m_neighbours[i * g_fluid_max_neighbours];
+			size_t found = 0;
+			float density = 0;
+			float near_density = 0;
+
+			for (int32_t ny = std::max(cy - 1, 0); ny <= std::min(cy + 1, m_grid_height - 1); ny++)
+			{
+				// the three cells of a row are contiguous in sorted order
+				const int32_t row = ny * m_grid_width;
+				const uint32_t first = m_cell_start[row + std::max(cx - 1, 0)];
+				const uint32_t last = m_cell_start[row + std::min(cx + 1, m_grid_width - 1) + 1];
+
+				for (uint32_t j = first; j < last; j++)
+				{
+					const float dx = ToFloat(m_x[j]) - xi;
+					const float dy = ToFloat(m_y[j]) - yi;
+					const float dist_sq = dx * dx + dy * dy;
+
+					if (dist_sq >= radius_sq || j == i)
+					{
+						continue;
+					}
+
+					const float w = 1.f - std::sqrt(dist_sq) * inv_radius;
+					density += w * w;
+					near_density += w * w * w;
+
+					if (found < g_fluid_max_neighbours)
+					{
+						neighbours[found++] = j;
+					}
+				}
+			}
+
+			m_neighbour_count[i] = static_cast<uint8_t>(found);
+			m_pressure[i] = m_settings.m_stiffness * (density - m_settings.m_rest_density);
+			m_near_pressure[i] = m_settings.m_near_stiffness * near_density;
+		}
+	}
+
+	void VertletFluid::Relax(const size_t begin, const size_t end)
+	{
+		const float inv_radius = 1.f / m_settings.m_interaction_radius;
+		const float viscosity = m_settings.m_viscosity;
+		// a particle never moves more than a quarter cell per update, keeps violent impacts from exploding
+		const float max_move = m_settings.m_interaction_radius * 0.25f;
+
+		for (size_t i = begin; i < end; i++)
+		{
+			const float xi = ToFloat(m_x[i]);
+			const float yi = ToFloat(m_y[i]);
+			const float vxi = ToFloat(m_x[i] - m_oldx[i]);
+			const float vyi = ToFloat(m_y[i] - m_oldy[i]);
+			const uint32_t* neighbours = &m_neighbours[i * g_fluid_max_neighbours];
+
+			float move_x = 0;
+			float move_y = 0;
+
+			for (size_t k = 0; k < m_neighbour_count[i]; k++)
+			{
+				const uint32_t j = neighbours[k];
+				const float dx = ToFloat(m_x[j]) - xi;
+				const float dy = ToFloat(m_y[j]) - yi;
+				const float dist = std::sqrt(dx * dx + dy * dy);
+
+				if (dist < 1.0e-4f)
+				{
+					continue;
+				}
+
+				const float w = 1.f - dist * inv_radius;
+				// half of the pair's displacement, the other half is applied when j visits i
+				const float push = 0.5f * ((m_pressure[i] + m_pressure[j]) * w + (m_near_pressure[i] + m_near_pressure[j]) * w * w);
+
+				move_x -= push * dx / dist;
+				move_y -= push * dy / dist;
+
+				// pull velocity towards the neighbours'
+				move_x += viscosity * w * (ToFloat(m_x[j] - m_oldx[j]) - vxi);
+				move_y += viscosity * w * (ToFloat(m_y[j] - m_oldy[j]) - vyi);
+			}
+
+			const float move_sq = move_x * move_x + move_y * move_y;
+
+			if (move_sq > max_move * max_move)
+			{
+				const float scale = max_move / std::sqrt(move_sq);
+				move_x *= scale;
+				move_y *= scale;
+			}
+
+			m_dx[i] = move_x;
+			m_dy[i] = move_y;
+		}
+	}
+
+	void VertletFluid::CollideBodies(const std::vector<VertletBody*>& bodies)
+	{
+		const float inv_cell = 1.f / m_settings.m_interaction_radius;
+		const float particle_radius = m_settings.m_particle_radius;
+		const float point_push = m_settings.m_point_push;
+
+		for (auto* body : bodies)
+		{
+			if ((body->Policy() & PolicyCollides) == 0)
+			{
+				continue;
+			}
+
+			for (auto* p : body->m_points)
+			{
+				const float px = ToFloat(p->m_x);
+				const float py = ToFloat(p->m_y);
+				const float min_dist = ToFloat(p->m_radius) + particle_radius;
+				const int32_t reach = static_cast<int32_t>(std::ceil(min_dist * inv_cell));
+				const int32_t cell = CellOf(px, py);
+				const int32_t cx = cell % m_grid_width;
+				const int32_t cy = cell / m_grid_width;
+
+				float point_move_x = 0;
+				float point_move_y = 0;
+
+				for (int32_t ny = std::max(cy - reach, 0); ny <= std::min(cy + reach, m_grid_height - 1); ny++)
+				{
+					const int32_t row = ny * m_grid_width;
+					const uint32_t first = m_cell_start[row + std::max(cx - reach, 0)];
+					const uint32_t last = m_cell_start[row + std::min(cx + reach, m_grid_width - 1) + 1];
+
+					for (uint32_t j = first; j < last; j++)
+					{
+						const float dx = ToFloat(m_x[j]) - px;
+						const float dy = ToFloat(m_y[j]) - py;
+						const float dist_sq = dx * dx + dy * dy;
+
+						if (dist_sq >= min_dist * min_dist || dist_sq < 1.0e-8f)
+						{
+							continue;
+						}
+
+						const float dist = std::sqrt(dist_sq);
+						const float overlap = (min_dist - dist) / dist;
+
+						m_x[j] += Real(dx * overlap * (1.f - point_push));
+						m_y[j] += Real(dy * overlap * (1.f - point_push));
+						point_move_x -= dx * overlap * point_push;
+						point_move_y -= dy * overlap * point_push;
+					}
+				}
+
+				if (!p->m_pinned)
+				{
+					p->m_x += Real(point_move_x);
+					p->m_y += Real(point_move_y);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "VertletParallel.h"
+#include "VertletPhysics.h"
+
+namespace VertletPhysics
+{
+	/* Neighbours kept per particle, extra ones in very dense spots are ignored */
+	const size_t g_fluid_max_neighbours = 32;
+
+	/**
+	 * \brief Fluid material parameters, distances in pixels
+	 */
+	struct FluidSettings
+	{
+		/* Interaction radius, also the grid cell size */
+		float m_interaction_radius{ 10.f };
+		/* Density the pressure pushes towards */
+		float m_rest_density{ 3.f };
+		/* Pressure per unit of density error */
+		float m_stiffness{ 0.3f };
+		/* Short range repulsion that stops particles clumping */
+		float m_near_stiffness{ 0.6f };
+		/* Velocity smoothing between neighbours */
+		float m_viscosity{ 0.05f };
+		/* Radius used for screen bounds and collisions with body points */
+		float m_particle_radius{ 2.f };
+		/* Share of a body collision correction taken by the body point */
+		float m_point_push{ 0.2f };
+	};
+
+	/**
+	 * \brief Smoothed particle hydrodynamics particles integrated like VertletPoints
+	 *
+	 * Particles are stored as flat arrays and re-sorted into grid cell order every update, so each
+	 * particle's neighbours sit next to it in memory. Pressure uses double density relaxation, a position
+	 * based SPH variant that suits Verlet integration and stays stable at a step of one frame. Neighbour,
+	 * density and relaxation passes run on a worker pool and only ever write to their own particle.
+	 */
+	class VertletFluid
+	{
+	public:
+		explicit VertletFluid(const FluidSettings& settings = FluidSettings());
+
+		VertletFluid(const VertletFluid&) = delete;
+		VertletFluid& operator=(const VertletFluid&) = delete;
+
+		~VertletFluid();
+
+		/**
+		 * \brief Adds a resting particle
+		 * \param x X position
+		 * \param y Y position
+		 */
+		void AddParticle(const Real x, const Real y);
+
+		/**
+		 * \brief Adds a rectangle of resting particles
+		 * \param x Top left x
+		 * \param y Top left y
+		 * \param columns Particles across
+		 * \param rows Particles down
+		 * \param spacing Distance between particles
+		 */
+		void AddBlock(const Real x, const Real y, const int32_t columns, const int32_t rows, const Real spacing);
+
+		void Clear();
+
+		size_t Size() const { return m_x.size(); }
+
+		/**
+		 * \brief Integrates the particles, relaxes them towards rest density, then pushes them out of body points and the screen edges
+		 * \param screen_width Width of the game screen
+		 * \param screen_height Height of the game screen
+		 * \param settings Gravity, friction and bounce shared with the bodies
+		 * \param bodies Bodies whose points collide with the particles, two way
+		 */
+		void Update(const int32_t screen_width, const int32_t screen_height, const VertletSettings& settings, const std::vector<VertletBody*>& bodies);
+
+		/**
+		 * \brief Appends every particle to a snapshot
+		 * \param out Snapshot to append to
+		 */
+		void WriteSnapshot(VertletSnapshot& out) const;
+
+	private:
+		/**
+		 * \brief Counting sorts the particles by grid cell and reorders every particle array to match
+		 */
+		void SortIntoGrid(const int32_t screen_width, const int32_t screen_height);
+
+		/**
+		 * \brief Fills the neighbour lists and computes density and pressure
+		 */
+		void FindNeighbours(const size_t begin, const size_t end);
+
+		/**
+		 * \brief Computes each particle's pressure and viscosity displacement from its neighbours
+		 */
+		void Relax(const size_t begin, const size_t end);
+
+		/**
+		 * \brief Pushes particles and body points apart using the grid
+		 */
+		void CollideBodies(const std::vector<VertletBody*>& bodies);
+
+		/**
+		 * \brief Grid cell of a position, clamped to the grid
+		 */
+		int32_t CellOf(const float x, const float y) const;
+
+		FluidSettings m_settings;
+
+		/* Particle state, same meaning as the VertletPoint fields */
+		std::vector<Real> m_x;
+		std::vector<Real> m_y;
+		std::vector<Real> m_oldx;
+		std::vector<Real> m_oldy;
+
+		/* Per update working arrays, indexed in sorted order */
+		std::vector<float> m_pressure;
+		std::vector<float> m_near_pressure;
+		std::vector<float> m_dx;
+		std::vector<float> m_dy;
+		std::vector<uint32_t> m_neighbours;
+		std::vector<uint8_t> m_neighbour_count;
+
+		/* Uniform grid, particles of cell c are [m_cell_start[c], m_cell_start[c + 1]) */
+		int32_t m_grid_width{ 0 };
+		int32_t m_grid_height{ 0 };
+		std::vector<uint32_t> m_cell_start;
+		std::vector<uint32_t> m_cell;
+		std::vector<uint32_t> m_cell_cursor;
+		std::vector<uint32_t> m_order;
+		std::vector<Real> m_sort_scratch;
+
+		/* Created on the first update that has particles */
+		std::unique_ptr<ParallelPool> m_pool;
+	};
+}
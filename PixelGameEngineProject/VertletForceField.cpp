@@ -0,0 +1,227 @@
+#include "VertletForceField.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "VertletPhysics.h"
+
+namespace VertletPhysics
+{
+	/*
+	 * Field kernels, each is a branch free loop over flat __restrict arrays so no alias check is needed. Checked with
+	 * GCC 12 -fopt-info-vec: all three vectorise at -O3 and at -O2 -fvect-cost-model=cheap, none at plain -O2.
+	 */
+
+	/**
+	 * \brief Sine without a library call, so the wind loop stays vectorisable, within 5e-4 of std::sin
+	 */
+	static inline float GustSin(const float t)
+	{
+		const float pi = 3.14159265f;
+		// wrap to [-pi, pi], the truncating conversion vectorises where rounding functions may not
+		const float turns = t * (0.5f / pi);
+		const float wrapped = t - 2.f * pi * static_cast<float>(static_cast<int32_t>(turns + (turns >= 0.f ? 0.5f : -0.5f)));
+		const float w2 = wrapped * wrapped;
+		// odd Taylor series to the 11th power, good enough over the whole range for gust strength
+		return wrapped * (1.f + w2 * (-1.f / 6.f + w2 * (1.f / 120.f + w2 * (-1.f / 5040.f + w2 * (1.f / 362880.f + w2 * (-1.f / 39916800.f))))));
+	}
+
+	/**
+	 * \brief 1 / sqrt(value) from a bit guess and two Newton steps, within 5e-6, huge but finite for 0. std::sqrt keeps
+	 * GCC's errno branch in the loop unless -fno-math-errno is set
+	 */
+	static inline float InvSqrt(const float value)
+	{
+		int32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		bits = 0x5f375a86 - (bits >> 1);
+
+		float result;
+		std::memcpy(&result, &bits, sizeof(result));
+
+		result *= 1.5f - 0.5f * value * result * result;
+		result *= 1.5f - 0.5f * value * result * result;
+		return result;
+	}
+
+	static void ApplyWind(const WindField& field, const float time, const size_t count, const float* __restrict x, const float* __restrict y, float* __restrict ax, float* __restrict ay)
+	{
+		const ForceFieldBounds r = field.m_region;
+		const float gx = field.m_dir_x * field.m_strength;
+		const float gy = field.m_dir_y * field.m_strength;
+		const float noise = field.m_noise;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			// & rather than && so the test doesn't branch
+			const float inside = ((x[i] >= r.m_min_x) & (x[i] <= r.m_max_x) & (y[i] >= r.m_min_y) & (y[i] <= r.m_max_y)) ? 1.f : 0.f;
+			// gusts travel across the screen, cheap enough to not need a noise texture
+			const float gust = 1.f + noise * GustSin(x[i] * 0.031f + y[i] * 0.017f - time * 0.05f);
+
+			ax[i] += gx * gust * inside;
+			ay[i] += gy * gust * inside;
+		}
+	}
+
+	static void ApplyRadial(const RadialField& field, const bool vortex, const size_t count, const float* __restrict x, const float* __restrict y, float* __restrict ax, float* __restrict ay)
+	{
+		const float inv_radius = 1.f / field.m_radius;
+		// vortex pushes along the tangent instead of towards the centre
+		const float along = vortex ? 0.f : 1.f;
+		const float across = vortex ? 1.f : 0.f;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const float dx = field.m_x - x[i];
+			const float dy = field.m_y - y[i];
+			// clamped after the root, a select feeding the bit cast stops GCC from if converting the loop
+			const float guess = InvSqrt(dx * dx + dy * dy);
+			const float inv_dist = guess < 1.f ? guess : 1.f;
+			// linear falloff to zero at the radius, (1 - dist / radius) / dist without a division
+			const float falloff = inv_dist - inv_radius;
+			const float scale = field.m_strength * (falloff > 0.f ? falloff : 0.f);
+
+			ax[i] += (dx * along - dy * across) * scale;
+			ay[i] += (dy * along + dx * across) * scale;
+		}
+	}
+
+	static void ApplyDrag(const DragField& field, const size_t count, const float* __restrict x, const float* __restrict y, const float* __restrict vx, const float* __restrict vy, float* __restrict ax, float* __restrict ay)
+	{
+		const ForceFieldBounds r = field.m_region;
+		const float coefficient = field.m_coefficient;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const float inside = ((x[i] >= r.m_min_x) & (x[i] <= r.m_max_x) & (y[i] >= r.m_min_y) & (y[i] <= r.m_max_y)) ? 1.f : 0.f;
+
+			ax[i] -= vx[i] * coefficient * inside;
+			ay[i] -= vy[i] * coefficient * inside;
+		}
+	}
+
+	size_t VertletForceFields::AddWind(const float dir_x, const float dir_y, const float strength, const float noise, const ForceFieldBounds& region)
+	{
+		const float length = std::sqrt(dir_x * dir_x + dir_y * dir_y);
+		const float inv_length = length > 0.f ? 1.f / length : 0.f;
+
+		m_winds.push_back({ region, dir_x * inv_length, dir_y * inv_length, strength, noise });
+		return m_winds.size() - 1;
+	}
+
+	size_t VertletForceFields::AddAttractor(const float x, const float y, const float radius, const float strength)
+	{
+		m_attractors.push_back({ x, y, std::max(radius, 1.f), strength });
+		return m_attractors.size() - 1;
+	}
+
+	size_t VertletForceFields::AddVortex(const float x, const float y, const float radius, const float strength)
+	{
+		m_vortices.push_back({ x, y, std::max(radius, 1.f), strength });
+		return m_vortices.size() - 1;
+	}
+
+	size_t VertletForceFields::AddDrag(const ForceFieldBounds& region, const float coefficient)
+	{
+		m_drags.push_back({ region, coefficient });
+		return m_drags.size() - 1;
+	}
+
+	void VertletForceFields::Clear()
+	{
+		m_winds.clear();
+		m_attractors.clear();
+		m_vortices.clear();
+		m_drags.clear();
+	}
+
+	bool VertletForceFields::Evaluate(const std::vector<VertletPoint*>& points, const float step_scale, ForceFieldScratch& scratch) const
+	{
+		const size_t count = points.size();
+
+		if (count == 0 || Empty())
+		{
+			return false;
+		}
+
+		scratch.m_x.resize(count);
+		scratch.m_y.resize(count);
+		scratch.m_vx.resize(count);
+		scratch.m_vy.resize(count);
+
+		const float inv_step = 1.f / step_scale;
+
+		// gather positions once for every field, finding the body bounds on the way
+		ForceFieldBounds bounds{ 1.0e30f, 1.0e30f, -1.0e30f, -1.0e30f };
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const VertletPoint* p = points[i];
+			const float x = ToFloat(p->m_x);
+			const float y = ToFloat(p->m_y);
+
+			scratch.m_x[i] = x;
+			scratch.m_y[i] = y;
+			scratch.m_vx[i] = ToFloat(p->m_x - p->m_oldx) * inv_step;
+			scratch.m_vy[i] = ToFloat(p->m_y - p->m_oldy) * inv_step;
+
+			bounds.m_min_x = std::min(bounds.m_min_x, x);
+			bounds.m_min_y = std::min(bounds.m_min_y, y);
+			bounds.m_max_x = std::max(bounds.m_max_x, x);
+			bounds.m_max_y = std::max(bounds.m_max_y, y);
+		}
+
+		const float* x = scratch.m_x.data();
+		const float* y = scratch.m_y.data();
+		bool touched = false;
+
+		// zeroes the result the first time any field reaches the body
+		auto begin = [&]()
+		{
+			if (!touched)
+			{
+				scratch.m_ax.assign(count, 0.f);
+				scratch.m_ay.assign(count, 0.f);
+				touched = true;
+			}
+		};
+
+		for (const auto& field : m_winds)
+		{
+			if (field.m_region.Overlaps(bounds))
+			{
+				begin();
+				ApplyWind(field, m_time, count, x, y, scratch.m_ax.data(), scratch.m_ay.data());
+			}
+		}
+
+		for (const auto& field : m_attractors)
+		{
+			if (field.Bounds().Overlaps(bounds))
+			{
+				begin();
+				ApplyRadial(field, false, count, x, y, scratch.m_ax.data(), scratch.m_ay.data());
+			}
+		}
+
+		for (const auto& field : m_vortices)
+		{
+			if (field.Bounds().Overlaps(bounds))
+			{
+				begin();
+				ApplyRadial(field, true, count, x, y, scratch.m_ax.data(), scratch.m_ay.data());
+			}
+		}
+
+		for (const auto& field : m_drags)
+		{
+			if (field.m_region.Overlaps(bounds))
+			{
+				begin();
+				ApplyDrag(field, count, x, y, scratch.m_vx.data(), scratch.m_vy.data(), scratch.m_ax.data(), scratch.m_ay.data());
+			}
+		}
+
+		return touched;
+	}
+}
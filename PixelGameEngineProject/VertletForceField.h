@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VertletPhysics
+{
+	struct VertletPoint;
+
+	/**
+	 * \brief Axis aligned box used to cull fields against bodies
+	 */
+	struct ForceFieldBounds
+	{
+		float m_min_x;
+		float m_min_y;
+		float m_max_x;
+		float m_max_y;
+
+		bool Overlaps(const ForceFieldBounds& other) const
+		{
+			return m_min_x <= other.m_max_x && other.m_min_x <= m_max_x && m_min_y <= other.m_max_y && other.m_min_y <= m_max_y;
+		}
+
+		/* Bounds covering every point */
+		static ForceFieldBounds Everywhere() { return { -1.0e30f, -1.0e30f, 1.0e30f, 1.0e30f }; }
+	};
+
+	/**
+	 * \brief Constant push in one direction, gusting along its length
+	 */
+	struct WindField
+	{
+		ForceFieldBounds m_region;
+		/* Unit direction */
+		float m_dir_x;
+		float m_dir_y;
+		/* Acceleration in pixels per frame squared */
+		float m_strength;
+		/* 0 - 1, how much the gusts vary the strength */
+		float m_noise;
+	};
+
+	/**
+	 * \brief Force around a centre that fades to nothing at the radius, used by attractors and vortices
+	 */
+	struct RadialField
+	{
+		float m_x;
+		float m_y;
+		float m_radius;
+		/* Acceleration at the centre in pixels per frame squared, negative repels or spins the other way */
+		float m_strength;
+
+		ForceFieldBounds Bounds() const { return { m_x - m_radius, m_y - m_radius, m_x + m_radius, m_y + m_radius }; }
+	};
+
+	/**
+	 * \brief Region that removes a fraction of the velocity of points inside it
+	 */
+	struct DragField
+	{
+		ForceFieldBounds m_region;
+		/* Fraction of velocity removed per frame */
+		float m_coefficient;
+	};
+
+	/**
+	 * \brief Per body working arrays for field evaluation, reused each update so nothing is allocated once warm
+	 */
+	struct ForceFieldScratch
+	{
+		std::vector<float> m_x;
+		std::vector<float> m_y;
+		std::vector<float> m_vx;
+		std::vector<float> m_vy;
+		/* Summed acceleration per point, indexed like the body's points */
+		std::vector<float> m_ax;
+		std::vector<float> m_ay;
+	};
+
+	/**
+	 * \brief Set of force fields acting on a world
+	 *
+	 * Fields are stored per type so evaluation is one tight loop per field over flat position arrays,
+	 * without a virtual call per point. Fields are evaluated in float in both Real modes, so fixed point
+	 * worlds using them are only deterministic on one platform.
+	 */
+	class VertletForceFields
+	{
+	public:
+		/**
+		 * \brief Adds a wind field
+		 * \param dir_x Direction x, normalised here
+		 * \param dir_y Direction y, normalised here
+		 * \param strength Acceleration in pixels per frame squared
+		 * \param noise 0 - 1, how much gusts vary the strength
+		 * \param region Area the wind blows in
+		 * \return Index into Winds
+		 */
+		size_t AddWind(const float dir_x, const float dir_y, const float strength, const float noise = 0.f, const ForceFieldBounds& region = ForceFieldBounds::Everywhere());
+
+		/**
+		 * \brief Adds a field pulling points towards a centre, negative strength pushes them away
+		 * \return Index into Attractors
+		 */
+		size_t AddAttractor(const float x, const float y, const float radius, const float strength);
+
+		/**
+		 * \brief Adds a field spinning points around a centre, positive strength is clockwise on screen
+		 * \return Index into Vortices
+		 */
+		size_t AddVortex(const float x, const float y, const float radius, const float strength);
+
+		/**
+		 * \brief Adds a region that slows points down
+		 * \return Index into Drags
+		 */
+		size_t AddDrag(const ForceFieldBounds& region, const float coefficient);
+
+		void Clear();
+
+		bool Empty() const { return m_winds.empty() && m_attractors.empty() && m_vortices.empty() && m_drags.empty(); }
+
+		/**
+		 * \brief Moves the wind gusts along
+		 * \param frames Time passed in frames
+		 */
+		void Advance(const float frames) { m_time += frames; }
+
+		/**
+		 * \brief Sums the acceleration of every field over every point, skipping fields outside the points' bounds
+		 * \param points Points to evaluate at
+		 * \param step_scale Step length in frames, converts the stored velocity to per frame
+		 * \param scratch Working arrays, m_ax and m_ay hold the result in pixels per frame squared
+		 * \return False if no field reaches the points, scratch is then left unset
+		 */
+		bool Evaluate(const std::vector<VertletPoint*>& points, const float step_scale, ForceFieldScratch& scratch) const;
+
+		std::vector<WindField>& Winds() { return m_winds; }
+		std::vector<RadialField>& Attractors() { return m_attractors; }
+		std::vector<RadialField>& Vortices() { return m_vortices; }
+		std::vector<DragField>& Drags() { return m_drags; }
+
+	private:
+		std::vector<WindField> m_winds;
+		std::vector<RadialField> m_attractors;
+		std::vector<RadialField> m_vortices;
+		std::vector<DragField> m_drags;
+
+		/* Frames advanced, scrolls the gust pattern */
+		float m_time{ 0 };
+	};
+}
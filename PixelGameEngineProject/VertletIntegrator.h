@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include "FixedPoint.h"
+
+/*
+ * Integration and screen bounds steps shared by VertletPoint and the fluid particles, written against
+ * plain coordinates so either storage layout can use them
+ */
+
+namespace VertletPhysics
+{
+	/**
+	 * \brief Verlet step for one position
+	 * \param x Current x, moved
+	 * \param y Current y, moved
+	 * \param oldx Previous x, set to the current x
+	 * \param oldy Previous y, set to the current y
+	 * \param mod_x Amount removed from the x velocity
+	 * \param mod_y Amount removed from the y velocity
+	 * \param accel_x Acceleration added to x for this step
+	 * \param accel_y Acceleration added to y for this step
+	 * \param friction Velocity multiplier for this step
+	 */
+	inline void IntegrateVerlet(Real& x, Real& y, Real& oldx, Real& oldy, const Real mod_x, const Real mod_y, const Real accel_x, const Real accel_y, const Real friction)
+	{
+		// calc velocity, apply mouse effect
+		const auto vx = (x - oldx - mod_x) * friction;
+		const auto vy = (y - oldy - mod_y) * friction;
+
+		// update old pos for next frame
+		oldx = x;
+		oldy = y;
+
+		// apply velocity
+		x += vx;
+		y += vy;
+		// apply gravity and fields
+		x += accel_x;
+		y += accel_y;
+	}
+
+	/**
+	 * \brief Keeps a position inside the screen, reflecting its velocity off any edge it hits
+	 * \param x Current x
+	 * \param y Current y
+	 * \param oldx Previous x, moved to reflect the velocity
+	 * \param oldy Previous y, moved to reflect the velocity
+	 * \param radius Distance kept from the edges
+	 * \param screen_width Width of the screen
+	 * \param screen_height Height of the screen
+	 * \param friction Velocity multiplier applied to the reflected velocity
+	 * \param bounce Velocity reduction on collision
+	 */
+	inline void ConstrainToScreen(Real& x, Real& y, Real& oldx, Real& oldy, const Real radius, const int32_t screen_width, const int32_t screen_height, const Real friction, const Real bounce)
+	{
+		const auto vx = (x - oldx) * friction;
+		const auto vy = (y - oldy) * friction;
+
+		// confine x to screen bounds
+		if (x >= screen_width - radius)
+		{
+			x = screen_width - radius;
+			// invert x velocity, apply bounce speed reduction
+			oldx = x + vx * bounce;
+		}
+		else if (x < 0 + radius)
+		{
+			x = 0 + radius;
+			oldx = x + vx * bounce;
+		}
+
+		// confine y to screen bounds
+		if (y >= screen_height - radius)
+		{
+			y = screen_height - radius;
+			// invert y velocity, apply bounce speed reduction
+			oldy = y + vy * bounce;
+		}
+		else if (y < 0 + radius)
+		{
+			y = 0 + radius;
+			oldy = y + vy * bounce;
+		}
+	}
+}
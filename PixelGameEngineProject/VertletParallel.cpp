@@ -0,0 +1,117 @@
+#include "VertletParallel.h"
+
+#include <algorithm>
+
+namespace VertletPhysics
+{
+	ParallelPool::ParallelPool(size_t workers)
+	{
+		if (workers == 0)
+		{
+			const size_t hw_threads = std::thread::hardware_concurrency();
+			workers = hw_threads > 1 ? hw_threads - 1 : 0;
+		}
+
+		for (size_t i = 0; i < workers; i++)
+		{
+			m_workers.emplace_back([this]() { WorkerLoop(); });
+		}
+	}
+
+	ParallelPool::~ParallelPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+
+		m_wake.notify_all();
+
+		for (auto& worker : m_workers)
+		{
+			worker.join();
+		}
+	}
+
+	void ParallelPool::For(const size_t count, const size_t grain, const RangeFunction& function)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		// not worth waking anyone
+		if (m_workers.empty() || count <= grain)
+		{
+			function(0, count);
+			return;
+		}
+
+		// a few chunks per thread so uneven ranges balance out
+		const size_t threads = m_workers.size() + 1;
+		const size_t chunk = std::max(grain, (count + threads * 4 - 1) / (threads * 4));
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_function = &function;
+			m_count = count;
+			m_chunk = chunk;
+			m_next.store(0, std::memory_order_relaxed);
+			m_active = m_workers.size();
+			m_generation++;
+		}
+
+		m_wake.notify_all();
+
+		RunChunks();
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done.wait(lock, [this]() { return m_active == 0; });
+		m_function = nullptr;
+	}
+
+	void ParallelPool::WorkerLoop()
+	{
+		uint64_t seen_generation = 0;
+
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_wake.wait(lock, [&]() { return m_stop || m_generation != seen_generation; });
+
+				if (m_stop)
+				{
+					return;
+				}
+
+				seen_generation = m_generation;
+			}
+
+			RunChunks();
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (--m_active == 0)
+				{
+					m_done.notify_one();
+				}
+			}
+		}
+	}
+
+	void ParallelPool::RunChunks()
+	{
+		for (;;)
+		{
+			const size_t begin = m_next.fetch_add(m_chunk, std::memory_order_relaxed);
+
+			if (begin >= m_count)
+			{
+				return;
+			}
+
+			(*m_function)(begin, std::min(begin + m_chunk, m_count));
+		}
+	}
+}
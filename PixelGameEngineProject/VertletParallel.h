@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VertletPhysics
+{
+	/**
+	 * \brief Persistent worker threads for data parallel passes, cheap enough to use several times per step
+	 */
+	class ParallelPool
+	{
+	public:
+		/* Called with a [begin, end) range of indices */
+		using RangeFunction = std::function<void(size_t begin, size_t end)>;
+
+		/**
+		 * \param workers Threads started besides the caller, 0 uses one less than the hardware thread count
+		 */
+		explicit ParallelPool(size_t workers = 0);
+
+		ParallelPool(const ParallelPool&) = delete;
+		ParallelPool& operator=(const ParallelPool&) = delete;
+
+		~ParallelPool();
+
+		/**
+		 * \brief Splits [0, count) into chunks and runs them on the workers and the calling thread, returns once all are done
+		 * \param count Number of indices
+		 * \param grain Smallest chunk worth handing to another thread
+		 * \param function Called once per chunk, must be safe to run concurrently on disjoint ranges
+		 */
+		void For(const size_t count, const size_t grain, const RangeFunction& function);
+
+		size_t Workers() const { return m_workers.size(); }
+
+	private:
+		void WorkerLoop();
+
+		/* Claims and runs chunks of the current job until none are left */
+		void RunChunks();
+
+		std::vector<std::thread> m_workers;
+
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_done;
+
+		/* Current job, written under the mutex before the generation changes */
+		const RangeFunction* m_function{ nullptr };
+		size_t m_count{ 0 };
+		size_t m_chunk{ 0 };
+		std::atomic<size_t> m_next{ 0 };
+
+		/* Workers yet to finish the current job */
+		size_t m_active{ 0 };
+		uint64_t m_generation{ 0 };
+		bool m_stop{ false };
+	};
+}
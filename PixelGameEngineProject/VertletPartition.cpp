@@ -0,0 +1,188 @@
+#include "VertletPartition.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace VertletPhysics
+{
+	/**
+	 * \brief Partition count to use for a requested count
+	 */
+	static size_t ResolvePartitions(const size_t partitions)
+	{
+		return partitions > 0 ? partitions : std::max<size_t>(1, std::thread::hardware_concurrency());
+	}
+
+	PartitionedBody::PartitionedBody(std::vector<VertletPoint*>& points, std::vector<VertletStick*>& sticks, const size_t partitions, const bool _draw_points) :
+		VertletBody(points, sticks, _draw_points),
+		m_partitions(ResolvePartitions(partitions))
+	{
+	}
+
+	PartitionedBody* PartitionedBody::Adopt(VertletBody* body, const size_t partitions)
+	{
+		auto* partitioned = new PartitionedBody(body->m_points, body->m_sticks, partitions, body->draw_points);
+		partitioned->m_cells = std::move(body->m_cells);
+		partitioned->m_lod = body->m_lod;
+		partitioned->SetPolicy(body->Policy());
+
+		// the points and sticks belong to the new body now, don't let the old one delete them
+		body->m_points.clear();
+		body->m_sticks.clear();
+		delete body;
+
+		return partitioned;
+	}
+
+	VertletBody::Factory PartitionedBody::CopyFactory() const
+	{
+		const Factory plain_factory = VertletBody::CopyFactory();
+		const size_t partitions = m_partitions;
+
+		return [plain_factory, partitions](std::vector<VertletPoint*>& points, std::vector<VertletStick*>& sticks, const std::vector<uint32_t>& stick_index) -> VertletBody*
+		{
+			return Adopt(plain_factory(points, sticks, stick_index), partitions);
+		};
+	}
+
+	size_t PartitionedBody::SolveConstraints(const VertletSettings& settings)
+	{
+		if (m_partitions < 2 || m_sticks.size() < g_partition_min_sticks)
+		{
+			return VertletBody::SolveConstraints(settings);
+		}
+
+		VERTLET_PROFILE_SCOPE(Sticks);
+
+		if (Revision() != m_partition_revision || m_sticks.size() != m_partition_stick_count)
+		{
+			BuildPartitions();
+		}
+
+		if (!m_pool)
+		{
+			m_pool = std::make_unique<ParallelPool>(m_partitions - 1);
+		}
+
+		// one strip per chunk, each writes only its own points and torn count
+		m_pool->For(m_partitions, 1, [&](const size_t begin, const size_t end)
+		{
+			for (size_t p = begin; p < end; p++)
+			{
+				const size_t first = m_partition_start[p];
+				m_partition_torn[p] = SolveSticks(m_interior_sticks.data() + first, m_partition_start[p + 1] - first, settings);
+			}
+		});
+
+		size_t torn = SolveSticks(m_boundary_sticks.data(), m_boundary_sticks.size(), settings);
+
+		for (const size_t partition_torn : m_partition_torn)
+		{
+			torn += partition_torn;
+		}
+
+		return torn;
+	}
+
+	void PartitionedBody::BuildPartitions()
+	{
+		m_partition_revision = Revision();
+		m_partition_stick_count = m_sticks.size();
+
+		m_interior_sticks.clear();
+		m_boundary_sticks.clear();
+		m_partition_start.assign(m_partitions + 1, 0);
+		m_partition_torn.assign(m_partitions, 0);
+		m_cuts.assign(m_partitions - 1, 0.f);
+
+		if (m_points.empty())
+		{
+			return;
+		}
+
+		// strips run across the longer axis so the cuts, and with them the boundary, are as short as possible
+		float min_x = ToFloat(m_points[0]->m_x), max_x = min_x;
+		float min_y = ToFloat(m_points[0]->m_y), max_y = min_y;
+
+		for (const auto* p : m_points)
+		{
+			min_x = std::min(min_x, ToFloat(p->m_x));
+			max_x = std::max(max_x, ToFloat(p->m_x));
+			min_y = std::min(min_y, ToFloat(p->m_y));
+			max_y = std::max(max_y, ToFloat(p->m_y));
+		}
+
+		const bool along_x = max_x - min_x >= max_y - min_y;
+		const float axis_min = along_x ? min_x : min_y;
+		const float extent = std::max(along_x ? max_x - min_x : max_y - min_y, 1.0e-3f);
+		auto coordinate = [along_x](const VertletPoint* p) { return ToFloat(along_x ? p->m_x : p->m_y); };
+
+		// equal point counts per strip from a histogram, avoids sorting millions of points
+		const size_t bins = m_partitions * g_partition_bins;
+		const float bin_scale = bins / extent;
+		m_histogram.assign(bins, 0);
+
+		for (const auto* p : m_points)
+		{
+			m_histogram[std::min(static_cast<size_t>((coordinate(p) - axis_min) * bin_scale), bins - 1)]++;
+		}
+
+		size_t cumulative = 0;
+		size_t cut = 0;
+
+		for (size_t bin = 0; bin < bins && cut < m_cuts.size(); bin++)
+		{
+			cumulative += m_histogram[bin];
+
+			while (cut < m_cuts.size() && cumulative * m_partitions >= (cut + 1) * m_points.size())
+			{
+				m_cuts[cut++] = axis_min + (bin + 1) / bin_scale;
+			}
+		}
+
+		// a point's strip only depends on its position, so every stick agrees on which strip a shared point is in
+		auto partition_of = [&](const VertletPoint* p)
+		{
+			return static_cast<uint32_t>(std::upper_bound(m_cuts.begin(), m_cuts.end(), coordinate(p)) - m_cuts.begin());
+		};
+
+		const uint32_t boundary = static_cast<uint32_t>(m_partitions);
+		m_stick_partition.resize(m_sticks.size());
+
+		for (size_t i = 0; i < m_sticks.size(); i++)
+		{
+			const uint32_t a = partition_of(m_sticks[i]->m_pa);
+			const uint32_t b = partition_of(m_sticks[i]->m_pb);
+
+			m_stick_partition[i] = a == b ? a : boundary;
+
+			if (a == b)
+			{
+				m_partition_start[a + 1]++;
+			}
+		}
+
+		for (size_t p = 0; p < m_partitions; p++)
+		{
+			m_partition_start[p + 1] += m_partition_start[p];
+		}
+
+		// counting sort keeps each strip's sticks in m_sticks order
+		m_interior_sticks.resize(m_partition_start[m_partitions]);
+		std::vector<size_t> cursor(m_partition_start.begin(), m_partition_start.end() - 1);
+
+		for (size_t i = 0; i < m_sticks.size(); i++)
+		{
+			const uint32_t p = m_stick_partition[i];
+
+			if (p == boundary)
+			{
+				m_boundary_sticks.push_back(m_sticks[i]);
+			}
+			else
+			{
+				m_interior_sticks[cursor[p]++] = m_sticks[i];
+			}
+		}
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "VertletParallel.h"
+#include "VertletPhysics.h"
+
+namespace VertletPhysics
+{
+	/* Bodies with fewer sticks than this solve serially, waking the pool costs more than it saves */
+	const size_t g_partition_min_sticks = 16384;
+	/* Histogram bins per partition used to place the partition boundaries */
+	const size_t g_partition_bins = 64;
+
+	/**
+	 * \brief Body whose stick pass is split into spatial partitions solved on a worker pool, for very large cloth
+	 *
+	 * The points are cut into strips of equal point count along the body's longer axis. A stick with both points
+	 * in one strip belongs to that strip's interior and a stick crossing strips is a boundary stick. Each pass solves
+	 * every strip's interior on its own thread, no two strips share a point so no locking is needed, then solves the
+	 * boundary sticks on the calling thread to reconcile the points along the cuts. Strips are rebuilt whenever a cut
+	 * or tear changes the sticks. The result depends on the partition count but not on thread timing.
+	 */
+	class PartitionedBody : public VertletBody
+	{
+	public:
+		/**
+		 * \param points Points
+		 * \param sticks Sticks
+		 * \param partitions Number of strips and threads, 0 for one per hardware thread
+		 * \param _draw_points Whether points are drawn
+		 */
+		PartitionedBody(std::vector<VertletPoint*>& points, std::vector<VertletStick*>& sticks, const size_t partitions = 0, const bool _draw_points = false);
+
+		/**
+		 * \brief Moves a freshly created plain body's points, sticks, cells and policy into a partitioned body
+		 * \param body Body to take over, deleted
+		 * \param partitions Number of strips and threads, 0 for one per hardware thread
+		 * \return The new body
+		 */
+		static PartitionedBody* Adopt(VertletBody* body, const size_t partitions = 0);
+
+		Factory CopyFactory() const override;
+
+		size_t Partitions() const { return m_partitions; }
+
+		/* Sticks crossing strips as of the last rebuild, solved serially */
+		size_t BoundaryStickCount() const { return m_boundary_sticks.size(); }
+
+	protected:
+		size_t SolveConstraints(const VertletSettings& settings) override;
+
+	private:
+		/**
+		 * \brief Places the strip boundaries and sorts the sticks into strip interiors and the boundary
+		 */
+		void BuildPartitions();
+
+		const size_t m_partitions;
+
+		/* Created on the first pass big enough to need it */
+		std::unique_ptr<ParallelPool> m_pool;
+
+		/* Interior sticks grouped by strip, strip p is [m_partition_start[p], m_partition_start[p + 1]) */
+		std::vector<VertletStick*> m_interior_sticks;
+		std::vector<size_t> m_partition_start;
+		std::vector<VertletStick*> m_boundary_sticks;
+		/* Sticks torn by each strip in the current pass */
+		std::vector<size_t> m_partition_torn;
+
+		/* State the partitions were built from, a change means they are stale */
+		uint64_t m_partition_revision{ UINT64_MAX };
+		size_t m_partition_stick_count{ 0 };
+
+		/* Reused by BuildPartitions */
+		std::vector<float> m_cuts;
+		std::vector<uint32_t> m_histogram;
+		std::vector<uint32_t> m_stick_partition;
+	};
+}
@@ -1,8 +1,129 @@
 #include "VertletPhysics.h"
 
+#include <algorithm>
+
 namespace VertletPhysics
 {
-	VertletPoint::VertletPoint(const float _x, const float _y, const float _oldx, const float _oldy, const bool pinned, const float radius, const bool should_draw) :
+	/**
+	 * \brief Verlet step for a single point
+	 * \param p Point to move
+	 * \param mouse_mod_x Mouse impulse removed from the x velocity
+	 * \param mouse_mod_y Mouse impulse removed from the y velocity
+	 * \param accel_x Force field acceleration for this step
+	 * \param accel_y Gravity plus force field acceleration for this step
+	 * \param friction Friction for this step
+	 */
+	static inline void IntegratePoint(VertletPoint* p, const Real mouse_mod_x, const Real mouse_mod_y, const Real accel_x, const Real accel_y, const Real friction)
+	{
+		IntegrateVerlet(p->m_x, p->m_y, p->m_oldx, p->m_oldy, mouse_mod_x, mouse_mod_y, accel_x, accel_y, friction);
+	}
+
+	/**
+	 * \brief Adjusts sticks' points to be stick length apart, sticks over the tear length are marked torn and left alone
+	 * \param sticks Sticks to solve in order
+	 * \param count Number of sticks
+	 * \param tear_ratio Tear length as a multiple of stick length, 0 disables tearing
+	 * \return Number of sticks newly torn
+	 * \tparam Pins False if no point is pinned
+	 */
+	template <bool Pins>
+	static size_t SolveStickRange(VertletStick* const* sticks, const size_t count, const Real tear_ratio)
+	{
+		const bool tearing = tear_ratio > Real(0);
+		size_t torn = 0;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			VertletStick* s = sticks[i];
+
+			const auto dx = s->m_pb->m_x - s->m_pa->m_x; // x distance
+			const auto dy = s->m_pb->m_y - s->m_pa->m_y; // y distance
+			const auto distance = Length(dx, dy); // distance between points
+
+			// reuses the distance the solve needs anyway, torn sticks stay in place until RemoveTornSticks
+			if (tearing && (s->m_torn || distance > s->m_length * tear_ratio))
+			{
+				torn += s->m_torn ? 0 : 1;
+				s->m_torn = true;
+				continue;
+			}
+
+			const auto difference = s->m_length - distance; // how displaced the points are from stick length
+			const auto percent = difference / distance / 2; // percent each point must move to align with stick len
+			const auto offset_x = dx * percent;
+			const auto offset_y = dy * percent;
+
+			// update points positions to be stick length apart
+			if (!Pins || !s->m_pa->m_pinned)
+			{
+				s->m_pa->m_x -= offset_x;
+				s->m_pa->m_y -= offset_y;
+			}
+
+			if (!Pins || !s->m_pb->m_pinned)
+			{
+				s->m_pb->m_x += offset_x;
+				s->m_pb->m_y += offset_y;
+			}
+		}
+
+		return torn;
+	}
+
+	/**
+	 * \brief XPBD pass over sticks, the points are unit mass and pinned points have no inverse mass
+	 * \param sticks Sticks to solve in order
+	 * \param count Number of sticks
+	 * \param tear_ratio Tear length as a multiple of stick length, 0 disables tearing
+	 * \param inv_step_sq One over the squared step length in frames, scales compliance to the step
+	 * \return Number of sticks newly torn
+	 * \tparam Pins False if no point is pinned
+	 */
+	template <bool Pins>
+	static size_t SolveStickRangeXpbd(VertletStick* const* sticks, const size_t count, const Real tear_ratio, const Real inv_step_sq)
+	{
+		const bool tearing = tear_ratio > Real(0);
+		size_t torn = 0;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			VertletStick* s = sticks[i];
+
+			const auto dx = s->m_pb->m_x - s->m_pa->m_x;
+			const auto dy = s->m_pb->m_y - s->m_pa->m_y;
+			const auto distance = Length(dx, dy);
+
+			if (tearing && (s->m_torn || distance > s->m_length * tear_ratio))
+			{
+				torn += s->m_torn ? 0 : 1;
+				s->m_torn = true;
+				continue;
+			}
+
+			const Real weight_a = Pins && s->m_pa->m_pinned ? Real(0) : Real(1);
+			const Real weight_b = Pins && s->m_pb->m_pinned ? Real(0) : Real(1);
+			const Real denominator = weight_a + weight_b + s->m_compliance * inv_step_sq;
+
+			if (denominator == Real(0))
+			{
+				continue;
+			}
+
+			// a single iteration per substep starts the multiplier at zero, so its change is the whole multiplier
+			const auto correction = (distance - s->m_length) / denominator / distance;
+			const auto offset_x = dx * correction;
+			const auto offset_y = dy * correction;
+
+			s->m_pa->m_x += offset_x * weight_a;
+			s->m_pa->m_y += offset_y * weight_a;
+			s->m_pb->m_x -= offset_x * weight_b;
+			s->m_pb->m_y -= offset_y * weight_b;
+		}
+
+		return torn;
+	}
+
+	VertletPoint::VertletPoint(const Real _x, const Real _y, const Real _oldx, const Real _oldy, const bool pinned, const Real radius, const bool should_draw) :
 		m_x(_x),
 		m_y(_y),
 		m_oldx(_oldx),
@@ -13,7 +134,9 @@ namespace VertletPhysics
 		m_touched(false),
 		m_cut(false),
 		m_owning_body(nullptr)
-	{}
+	{
+		VERTLET_PROFILE_COUNT(Allocations, 1);
+	}
 
 	void VertletPoint::Cut()
 	{
@@ -36,12 +159,26 @@ namespace VertletPhysics
 		delete this;
 	}
 
-	VertletStick::VertletStick(VertletPoint* pa, VertletPoint* pb, const float length, const bool hidden) :
+	void VertletPoint::DetachStick(const VertletStick* stick)
+	{
+		const auto it = std::find(m_attached_sticks.begin(), m_attached_sticks.end(), stick);
+
+		if (it != m_attached_sticks.end())
+		{
+			m_attached_sticks.erase(it);
+		}
+	}
+
+	VertletStick::VertletStick(VertletPoint* pa, VertletPoint* pb, const Real length, const bool hidden, const Real compliance) :
 		m_pa(pa),
 		m_pb(pb),
 		m_length(length),
-		m_hidden(hidden)
+		m_compliance(compliance),
+		m_hidden(hidden),
+		m_torn(false)
 	{
+		VERTLET_PROFILE_COUNT(Allocations, 1);
+
 		m_pa->m_attached_sticks.emplace_back(this);
 		m_pb->m_attached_sticks.emplace_back(this);
 	}
@@ -78,38 +215,235 @@ namespace VertletPhysics
 		{
 			point->m_owning_body = this;
 		}
+
+		// pins are added back by SetPolicy only if a point needs them
+		SetPolicy(PolicyAll & ~PolicyPins);
+	}
+
+	template <uint8_t Policy>
+	constexpr VertletBody::Kernels VertletBody::KernelsFor()
+	{
+		constexpr bool pins = (Policy & PolicyPins) != 0;
+		constexpr bool interactive = (Policy & PolicyInteractive) != 0;
+		constexpr bool bounded = (Policy & PolicyBounded) != 0;
+
+		return { &VertletBody::UpdatePoints<pins, interactive>, &VertletBody::UpdateSticks<pins>, &VertletBody::ConstrainPoints<pins, bounded> };
+	}
+
+	// collision is handled outside the body, policies differing only in PolicyCollides share kernels
+	const VertletBody::Kernels VertletBody::s_kernels[g_policy_count] =
+	{
+		KernelsFor<0>(), KernelsFor<1>(), KernelsFor<2>(), KernelsFor<3>(),
+		KernelsFor<4>(), KernelsFor<5>(), KernelsFor<6>(), KernelsFor<7>(),
+		KernelsFor<8>(), KernelsFor<9>(), KernelsFor<10>(), KernelsFor<11>(),
+		KernelsFor<12>(), KernelsFor<13>(), KernelsFor<14>(), KernelsFor<15>()
+	};
+
+	static_assert(g_policy_count == 16, "s_kernels needs an entry per policy");
+
+	void VertletBody::SetPolicy(const uint8_t policy)
+	{
+		// kernels without pins would move pinned points
+		const bool pinned = std::any_of(m_points.begin(), m_points.end(), [](const VertletPoint* p) { return p->m_pinned; });
+
+		m_policy = static_cast<uint8_t>((policy & PolicyAll) | (pinned ? PolicyPins : PolicyNone));
+		m_kernels = s_kernels[m_policy];
+	}
+
+	void VertletBody::Update(const int32_t screen_width, const int32_t screen_height, const olc::vf2d mouse_dir, const olc::vf2d mouse_pos, const bool cut_pressed, const VertletSettings& settings, const int32_t frames)
+	{
+		VERTLET_PROFILE_COUNT(Points, m_points.size());
+		VERTLET_PROFILE_COUNT(Sticks, m_sticks.size());
+
+		const int32_t substeps = settings.m_substeps;
+		const Real step_scale = substeps > 1 ? Real(frames) / substeps : Real(frames);
+		SetStepScale(step_scale);
+
+		// XPBD converges through substeps rather than repeated passes
+		const int32_t constrain_loops = settings.m_solver == VertletSolver::Xpbd ? 1 : settings.m_constrain_loops;
+
+		size_t torn = 0;
+
+		for (int32_t step = 0; step < substeps; step++)
+		{
+			// mouse interaction is a once per frame impulse
+			const bool first_step = step == 0;
+
+			(this->*m_kernels.m_update_points)(mouse_dir, mouse_pos, first_step && cut_pressed, first_step, step_scale, settings);
+
+			for (int32_t i = 1; i <= constrain_loops; i++)
+			{
+				torn += SolveConstraints(settings);
+				(this->*m_kernels.m_constrain_points)(screen_width, screen_height, settings);
+			}
+		}
+
+		// torn sticks are skipped by the solver until now, removing them all at once keeps the passes branch light
+		if (torn > 0)
+		{
+			VERTLET_PROFILE_COUNT(Tears, torn);
+			RemoveTornSticks();
+		}
+
+		UpdateBounds();
+	}
+
+	bool VertletBody::Bounds(olc::vf2d& out_min, olc::vf2d& out_max) const
+	{
+		out_min = m_bounds_min;
+		out_max = m_bounds_max;
+		return m_has_bounds;
+	}
+
+	void VertletBody::UpdateBounds()
+	{
+		m_has_bounds = !m_points.empty();
+
+		if (!m_has_bounds)
+		{
+			return;
+		}
+
+		Real min_x = m_points[0]->m_x, min_y = m_points[0]->m_y;
+		Real max_x = min_x, max_y = min_y;
+
+		for (const auto* p : m_points)
+		{
+			min_x = p->m_x < min_x ? p->m_x : min_x;
+			min_y = p->m_y < min_y ? p->m_y : min_y;
+			max_x = p->m_x > max_x ? p->m_x : max_x;
+			max_y = p->m_y > max_y ? p->m_y : max_y;
+		}
+
+		m_bounds_min = { ToFloat(min_x), ToFloat(min_y) };
+		m_bounds_max = { ToFloat(max_x), ToFloat(max_y) };
+	}
+
+	VertletBody::Factory VertletBody::CopyFactory() const
+	{
+		const bool body_draw_points = draw_points;
+		const std::vector<VertletCell> cells = m_cells;
+		const uint8_t policy = m_policy;
+
+		return [body_draw_points, cells, policy](std::vector<VertletPoint*>& points, std::vector<VertletStick*>& sticks, const std::vector<uint32_t>& stick_index) -> VertletBody*
+		{
+			auto* body = new VertletBody(points, sticks, body_draw_points);
+			body->SetPolicy(policy);
+
+			if (stick_index.empty())
+			{
+				body->m_cells = cells;
+				return body;
+			}
+
+			// sticks into bodies left out of a prototype are missing, the rest moved up, a cell goes only with its own sticks
+			for (VertletCell cell : cells)
+			{
+				uint32_t* edges[] = { &cell.m_top, &cell.m_left, &cell.m_bottom, &cell.m_right };
+				bool complete = true;
+
+				for (uint32_t* edge : edges)
+				{
+					*edge = *edge < stick_index.size() ? stick_index[*edge] : UINT32_MAX;
+					complete = complete && *edge != UINT32_MAX;
+				}
+
+				if (complete)
+				{
+					body->m_cells.push_back(cell);
+				}
+			}
+
+			return body;
+		};
 	}
 
-	void VertletBody::Update(const int32_t screen_width, const int32_t screen_height, const olc::vf2d mouse_dir, const olc::vf2d mouse_pos, const bool cut_pressed)
+	size_t VertletBody::SolveConstraints(const VertletSettings& settings)
 	{
-		UpdatePoints(mouse_dir, mouse_pos, cut_pressed);
+		return (this->*m_kernels.m_update_sticks)(settings);
+	}
 
-		for (size_t i = 1; i <= g_constrain_loops; i++)
+	void VertletBody::SetStepScale(const Real step_scale)
+	{
+		if (step_scale == m_step_scale)
 		{
-			UpdateSticks();
-			ConstrainPoints(screen_width, screen_height);
+			return;
 		}
+
+		// velocity is stored as distance moved per step, rescale it to the new step length
+		const Real ratio = step_scale / m_step_scale;
+
+		for (auto& p : m_points)
+		{
+			if (!p->m_pinned)
+			{
+				p->m_oldx = p->m_x - (p->m_x - p->m_oldx) * ratio;
+				p->m_oldy = p->m_y - (p->m_y - p->m_oldy) * ratio;
+			}
+		}
+
+		m_step_scale = step_scale;
 	}
 
-	void VertletBody::Render(olc::PixelGameEngine* renderer)
+	void VertletBody::WriteSnapshot(VertletSnapshot& out, const bool allow_points) const
 	{
-		// render points
-		for (const auto& p : m_points)
+		if (draw_points && allow_points)
 		{
-			if (p->m_should_draw && draw_points)
+			for (const auto& p : m_points)
 			{
-				const auto colour = p->m_touched ? olc::RED : olc::WHITE;
-				const auto radius = p->m_touched ? p->m_radius * 3 : p->m_radius;
-				renderer->FillCircle(p->m_x, p->m_y, radius, colour);
+				if (p->m_should_draw)
+				{
+					const auto radius = p->m_touched ? p->m_radius * 3 : p->m_radius;
+					out.m_points.push_back({ ToFloat(p->m_x), ToFloat(p->m_y), ToFloat(radius), p->m_touched });
+				}
 			}
 		}
 
-		// render sticks
-		for (const auto& s : m_sticks)
+		// sticks bordering an intact cell are drawn by the mesh unless cloth is drawn as wireframe
+		static thread_local std::vector<uint8_t> in_mesh;
+		in_mesh.assign(m_cells.empty() ? 0 : m_sticks.size(), 0);
+
+		const size_t first_vertex = out.m_mesh_positions.size();
+
+		for (const auto& cell : m_cells)
 		{
+			const VertletStick* top = m_sticks[cell.m_top];
+			const VertletStick* left = m_sticks[cell.m_left];
+			const VertletStick* bottom = m_sticks[cell.m_bottom];
+			const VertletStick* right = m_sticks[cell.m_right];
+
+			// a cut gives every stick of the cut point its own copy, so split corners mean the cell is open
+			if (top->m_pa != left->m_pa || top->m_pb != right->m_pa || left->m_pb != bottom->m_pa || bottom->m_pb != right->m_pb)
+			{
+				continue;
+			}
+
+			const olc::vf2d top_left{ ToFloat(top->m_pa->m_x), ToFloat(top->m_pa->m_y) };
+			const olc::vf2d top_right{ ToFloat(top->m_pb->m_x), ToFloat(top->m_pb->m_y) };
+			const olc::vf2d btm_left{ ToFloat(bottom->m_pa->m_x), ToFloat(bottom->m_pa->m_y) };
+			const olc::vf2d btm_right{ ToFloat(bottom->m_pb->m_x), ToFloat(bottom->m_pb->m_y) };
+
+			out.m_mesh_positions.insert(out.m_mesh_positions.end(), { top_left, top_right, btm_right, top_left, btm_right, btm_left });
+			out.m_mesh_uvs.insert(out.m_mesh_uvs.end(), { { cell.m_u0, cell.m_v0 }, { cell.m_u1, cell.m_v0 }, { cell.m_u1, cell.m_v1 },
+				{ cell.m_u0, cell.m_v0 }, { cell.m_u1, cell.m_v1 }, { cell.m_u0, cell.m_v1 } });
+
+			in_mesh[cell.m_top] = in_mesh[cell.m_left] = in_mesh[cell.m_bottom] = in_mesh[cell.m_right] = 1;
+		}
+
+		if (out.m_mesh_positions.size() > first_vertex)
+		{
+			out.m_meshes.push_back({ static_cast<uint32_t>(first_vertex), static_cast<uint32_t>(out.m_mesh_positions.size() - first_vertex) });
+		}
+
+		for (size_t i = 0; i < m_sticks.size(); i++)
+		{
+			const VertletStick* s = m_sticks[i];
+
 			if (!s->m_hidden)
 			{
-				renderer->DrawLine(s->m_pa->m_x, s->m_pa->m_y, s->m_pb->m_x, s->m_pb->m_y);
+				auto& lines = !in_mesh.empty() && in_mesh[i] ? out.m_mesh_lines : out.m_lines;
+				lines.push_back({ static_cast<int32_t>(ToFloat(s->m_pa->m_x)), static_cast<int32_t>(ToFloat(s->m_pa->m_y)),
+					static_cast<int32_t>(ToFloat(s->m_pb->m_x)), static_cast<int32_t>(ToFloat(s->m_pb->m_y)) });
 			}
 		}
 	}
@@ -120,124 +454,189 @@ namespace VertletPhysics
 
 		// add new point
 		m_points.push_back(new_point);
+
+		if (new_point->m_pinned && (m_policy & PolicyPins) == 0)
+		{
+			SetPolicy(m_policy);
+		}
 	}
 
-	void VertletBody::UpdatePoints(const olc::vf2d mouse_dir, const olc::vf2d mouse_pos, const bool cut)
+	template <bool Pins, bool Interactive>
+	void VertletBody::UpdatePoints(const olc::vf2d mouse_dir, const olc::vf2d mouse_pos, const bool cut, const bool interact, const Real step_scale, const VertletSettings& settings)
 	{
+		VERTLET_PROFILE_SCOPE(Integrate);
+
+		// forces are per frame, scale them to the step length, friction is linearised so fixed point needs no pow
+		const Real gravity = step_scale == Real(1) ? settings.m_gravity : settings.m_gravity * step_scale * step_scale;
+		const Real friction = step_scale == Real(1) ? settings.m_friction : Real(1) - (Real(1) - settings.m_friction) * step_scale;
+
+		// one pass per field over all points, then the per point loop only reads the summed result
+		bool forces = false;
+		if (settings.m_force_fields)
+		{
+			VERTLET_PROFILE_SCOPE(Forces);
+			forces = settings.m_force_fields->Evaluate(m_points, ToFloat(step_scale), m_force_scratch);
+		}
+		const float force_scale = ToFloat(step_scale * step_scale);
+
 		for (int i = m_points.size() - 1; i >= 0; i--)
 		{
 			VertletPoint* p = m_points[i];
 
-			if (!p->m_pinned)
+			// Pins and Interactive are compile time, the kernels without them carry neither test
+			if (Pins && p->m_pinned)
 			{
-				// reset mouse touched flag
-				p->m_touched = false;
+				continue;
+			}
 
-				// check if mouse is within the point
-				const float dx = mouse_pos.x - p->m_x;
-				const float dy = mouse_pos.y - p->m_y;
+			Real mouse_mod_x = 0;
+			Real mouse_mod_y = 0;
+			Real accel_x = 0;
+			Real accel_y = gravity;
 
-				const bool within = abs(dx) <= p->m_radius * 2 && abs(dy) <= p->m_radius * 2; // TODO radius detect tolerance!
+			if (forces)
+			{
+				accel_x += Real(m_force_scratch.m_ax[i] * force_scale);
+				accel_y += Real(m_force_scratch.m_ay[i] * force_scale);
+			}
+
+			// later substeps keep the touched state from the first
+			if (!Interactive || !interact)
+			{
+				IntegratePoint(p, mouse_mod_x, mouse_mod_y, accel_x, accel_y, friction);
+				continue;
+			}
 
-				float mouse_mod_x = 0;
-				float mouse_mod_y = 0;
+			// reset mouse touched flag
+			p->m_touched = false;
 
-				// calculate mouse effect to apply to the point vel
-				if (within)
-				{
-					mouse_mod_x = mouse_dir.x * 5.f; // TODO mouse move amount! maybe have point just follow mouse while inside its radius?
-					mouse_mod_y = mouse_dir.y * 5.f;
+			// check if mouse is within the point
+			const Real dx = Real(mouse_pos.x) - p->m_x;
+			const Real dy = Real(mouse_pos.y) - p->m_y;
 
-					p->m_touched = true;
+			const bool within = Abs(dx) <= p->m_radius * 2 && Abs(dy) <= p->m_radius * 2; // TODO radius detect tolerance!
 
-					if (cut)
-					{
-						p->Cut();
+			// calculate mouse effect to apply to the point vel
+			if (within)
+			{
+				mouse_mod_x = Real(mouse_dir.x) * 5 * step_scale; // TODO mouse move amount! maybe have point just follow mouse while inside its radius?
+				mouse_mod_y = Real(mouse_dir.y) * 5 * step_scale;
 
-						m_points.erase(m_points.begin() + i);
+				p->m_touched = true;
 
-						continue;
-					}
-				}
+				if (cut)
+				{
+					VERTLET_PROFILE_SCOPE(Cut);
+					VERTLET_PROFILE_COUNT(Cuts, 1);
 
-				// calc velocity, apply mouse effect
-				const auto vx = (p->m_x - p->m_oldx - mouse_mod_x) * g_friction;
-				const auto vy = (p->m_y - p->m_oldy - mouse_mod_y) * g_friction;
+					p->Cut();
 
-				// update old pos for next frame
-				p->m_oldx = p->m_x;
-				p->m_oldy = p->m_y;
+					m_points.erase(m_points.begin() + i);
+					m_revision++;
 
-				// apply velocity
-				p->m_x += vx;
-				p->m_y += vy;
-				// apply gravity
-				p->m_y += g_gravity;
+					continue;
+				}
 			}
+
+			IntegratePoint(p, mouse_mod_x, mouse_mod_y, accel_x, accel_y, friction);
 		}
 	}
 
-	void VertletBody::UpdateSticks()
+	template <bool Pins>
+	size_t VertletBody::UpdateSticks(const VertletSettings& settings)
 	{
-		for (auto& s : m_sticks)
+		VERTLET_PROFILE_SCOPE(Sticks);
+
+		if (settings.m_solver == VertletSolver::Xpbd)
 		{
-			const auto dx = s->m_pb->m_x - s->m_pa->m_x; // x distance
-			const auto dy = s->m_pb->m_y - s->m_pa->m_y; // y distance
-			const auto distance = sqrt(dx * dx + dy * dy); // distance between points
-			const auto difference = s->m_length - distance; // how displaced the points are from stick length
-			const auto percent = difference / distance / 2; // percent each point must move to align with stick len
-			const auto offset_x = dx * percent;
-			const auto offset_y = dy * percent;
+			return SolveStickRangeXpbd<Pins>(m_sticks.data(), m_sticks.size(), settings.m_tear_ratio, Real(1) / (m_step_scale * m_step_scale));
+		}
 
-			// update points positions to be stick length apart
-			if (!s->m_pa->m_pinned)
-			{
-				s->m_pa->m_x -= offset_x;
-				s->m_pa->m_y -= offset_y;
-			}
+		return SolveStickRange<Pins>(m_sticks.data(), m_sticks.size(), settings.m_tear_ratio);
+	}
 
-			if (!s->m_pb->m_pinned)
-			{
-				s->m_pb->m_x += offset_x;
-				s->m_pb->m_y += offset_y;
-			}
+	size_t VertletBody::SolveSticks(VertletStick* const* sticks, const size_t count, const VertletSettings& settings) const
+	{
+		const bool pins = (m_policy & PolicyPins) != 0;
+
+		if (settings.m_solver == VertletSolver::Xpbd)
+		{
+			const Real inv_step_sq = Real(1) / (m_step_scale * m_step_scale);
+			return pins ? SolveStickRangeXpbd<true>(sticks, count, settings.m_tear_ratio, inv_step_sq) : SolveStickRangeXpbd<false>(sticks, count, settings.m_tear_ratio, inv_step_sq);
 		}
+
+		return pins ? SolveStickRange<true>(sticks, count, settings.m_tear_ratio) : SolveStickRange<false>(sticks, count, settings.m_tear_ratio);
 	}
 
-	void VertletBody::ConstrainPoints(const int32_t screen_width, const int32_t screen_height)
+	void VertletBody::RemoveTornSticks()
 	{
-		for (auto& p : m_points)
+		size_t kept = 0;
+
+		// cells are dropped if they use a torn stick, otherwise their indices follow the compaction
+		if (!m_cells.empty())
 		{
-			if (!p->m_pinned)
-			{
-				const auto vx = (p->m_x - p->m_oldx) * g_friction;
-				const auto vy = (p->m_y - p->m_oldy) * g_friction;
+			size_t kept_cells = 0;
 
-				// confine x to screen bounds
-				if (p->m_x >= screen_width - p->m_radius)
-				{
-					p->m_x = screen_width - p->m_radius;
-					// invert x velocity, apply bounce speed reduction
-					p->m_oldx = p->m_x + vx * g_bounce;
-				}
-				else if (p->m_x < 0 + p->m_radius)
+			for (const auto& cell : m_cells)
+			{
+				if (!m_sticks[cell.m_top]->m_torn && !m_sticks[cell.m_left]->m_torn && !m_sticks[cell.m_bottom]->m_torn && !m_sticks[cell.m_right]->m_torn)
 				{
-					p->m_x = 0 + p->m_radius;
-					p->m_oldx = p->m_x + vx * g_bounce;
+					m_cells[kept_cells++] = cell;
 				}
+			}
 
-				// confine y to screen bounds
-				if (p->m_y >= screen_height - p->m_radius)
-				{
-					p->m_y = screen_height - p->m_radius;
-					// invert y velocity, apply bounce speed reduction
-					p->m_oldy = p->m_y + vy * g_bounce;
-				}
-				else if (p->m_y < 0 + p->m_radius)
+			m_cells.resize(kept_cells);
+			m_stick_remap.resize(m_sticks.size());
+		}
+
+		for (size_t i = 0; i < m_sticks.size(); i++)
+		{
+			VertletStick* s = m_sticks[i];
+
+			if (s->m_torn)
+			{
+				s->m_pa->DetachStick(s);
+				s->m_pb->DetachStick(s);
+				delete s;
+			}
+			else
+			{
+				if (!m_cells.empty())
 				{
-					p->m_y = 0 + p->m_radius;
-					p->m_oldy = p->m_y + vy * g_bounce;
+					m_stick_remap[i] = static_cast<uint32_t>(kept);
 				}
+
+				m_sticks[kept++] = s;
+			}
+		}
+
+		for (auto& cell : m_cells)
+		{
+			cell.m_top = m_stick_remap[cell.m_top];
+			cell.m_left = m_stick_remap[cell.m_left];
+			cell.m_bottom = m_stick_remap[cell.m_bottom];
+			cell.m_right = m_stick_remap[cell.m_right];
+		}
+
+		m_sticks.resize(kept);
+		m_revision++;
+	}
+
+	template <bool Pins, bool Bounded>
+	void VertletBody::ConstrainPoints(const int32_t screen_width, const int32_t screen_height, const VertletSettings& settings)
+	{
+		if constexpr (!Bounded)
+		{
+			return;
+		}
+
+		VERTLET_PROFILE_SCOPE(Bounds);
+
+		for (auto& p : m_points)
+		{
+			if (!Pins || !p->m_pinned)
+			{
+				ConstrainToScreen(p->m_x, p->m_y, p->m_oldx, p->m_oldy, p->m_radius, screen_width, screen_height, settings.m_friction, settings.m_bounce);
 			}
 		}
 	}
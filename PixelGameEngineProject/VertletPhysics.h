@@ -1,32 +1,109 @@
 #pragma once
 
+#include <functional>
 #include <vector>
 #include "olcPixelGameEngine.h"
+#include "FixedPoint.h"
+#include "VertletForceField.h"
+#include "VertletIntegrator.h"
+#include "VertletProfiler.h"
 
 namespace VertletPhysics
 {
 	struct VertletStick;
 	class VertletBody;
+	class ParallelPool;
 	
-	/* Velocity reduction on collision */
-	const float g_bounce = 0.9f;
-	/* Downwards force added to velocity each update */
-	const float g_gravity = 0.1f;
-	/* Amount to reduce velocity each update */
-	const float g_friction = 0.999f;
-	/* number of times to run the constrain logic each update, prevents wobbling of bodies */
+	/* Default velocity reduction on collision */
+	const Real g_bounce = 0.9f;
+	/* Default downwards force added to velocity each update */
+	const Real g_gravity = 0.1f;
+	/* Default amount to reduce velocity each update */
+	const Real g_friction = 0.999f;
+	/* Default number of times to run the constrain logic each update, prevents wobbling of bodies */
 	const int g_constrain_loops = 3;
+	/* Default stick tear ratio, 0 disables tearing */
+	const Real g_tear_ratio = 0;
+	/* Coarsest level of detail tier, bodies in tier n step every 2^n frames */
+	const uint8_t g_lod_max_tier = 3;
+
+	/* How sticks are solved */
+	enum class VertletSolver : uint8_t
+	{
+		/* Constrain loops position passes per substep, stiffness depends on the loop count and step length */
+		Pbd,
+		/* One compliance aware pass per substep, stiffness comes from each stick's m_compliance */
+		Xpbd
+	};
+
+	/**
+	 * \brief Per world simulation parameters, defaults match the g_ constants
+	 */
+	struct VertletSettings
+	{
+		/* Velocity reduction on collision */
+		Real m_bounce{ g_bounce };
+		/* Downwards force added to velocity each update */
+		Real m_gravity{ g_gravity };
+		/* Amount to reduce velocity each update */
+		Real m_friction{ g_friction };
+		/* Stick and bounds passes per substep */
+		int32_t m_constrain_loops{ g_constrain_loops };
+		/* Integration steps each update is split into */
+		int32_t m_substeps{ 1 };
+		/* Sticks stretched past this multiple of their length break, 0 disables tearing */
+		Real m_tear_ratio{ g_tear_ratio };
+		/* Stick solver, Xpbd ignores m_constrain_loops and wants several substeps instead */
+		VertletSolver m_solver{ VertletSolver::Pbd };
+		/* Fields added to gravity before integration, not owned, null for none */
+		const VertletForceFields* m_force_fields{ nullptr };
+	};
+
+	/**
+	 * \brief Features a body's update kernels are compiled for, combined as flags, a body pays only for the ones it has
+	 */
+	enum VertletPolicy : uint8_t
+	{
+		PolicyNone = 0,
+		/* Some points are pinned, without it every point moves */
+		PolicyPins = 1 << 0,
+		/* The mouse pushes and cuts points */
+		PolicyInteractive = 1 << 1,
+		/* Points are kept on screen */
+		PolicyBounded = 1 << 2,
+		/* Fluid particles push points */
+		PolicyCollides = 1 << 3,
+		PolicyAll = PolicyPins | PolicyInteractive | PolicyBounded | PolicyCollides
+	};
+
+	/* Number of distinct policies, one kernel set each */
+	const size_t g_policy_count = PolicyAll + 1;
+
+	/**
+	 * \brief Update rate scheduling of a body, tier n steps once every 2^n frames with a 2^n frame timestep
+	 */
+	struct VertletLod
+	{
+		/* Keeps the body at tier 2 or coarser wherever it is */
+		bool m_background{ false };
+		uint8_t m_tier{ 0 };
+		/* Stagger offset set by the world, bodies in the same tier with different slots step on different frames */
+		uint8_t m_slot{ 0 };
+		bool m_has_slot{ false };
+		/* Frames since the body last stepped */
+		uint8_t m_pending{ 0 };
+	};
 
 	/**
 	 * \brief Point that has physics forces applied to it
 	 */
 	struct VertletPoint
 	{
-		float m_x;
-		float m_y;
-		float m_oldx;
-		float m_oldy;
-		float m_radius;
+		Real m_x;
+		Real m_y;
+		Real m_oldx;
+		Real m_oldy;
+		Real m_radius;
 
 		bool m_should_draw;
 		bool m_pinned;		
@@ -37,9 +114,15 @@ namespace VertletPhysics
 
 		std::vector<VertletStick*> m_attached_sticks;
 
-		VertletPoint(const float _x, const float _y, const float _oldx, const float _oldy, const bool pinned = false, const float radius = 5.f, const bool should_draw = false);
+		VertletPoint(const Real _x, const Real _y, const Real _oldx, const Real _oldy, const bool pinned = false, const Real radius = 5.f, const bool should_draw = false);
 
 		void Cut();
+
+		/**
+		 * \brief Forgets a stick that no longer connects to this point
+		 * \param stick Stick to remove from m_attached_sticks
+		 */
+		void DetachStick(const VertletStick* stick);
 	};
 
 	/**
@@ -50,14 +133,136 @@ namespace VertletPhysics
 		VertletPoint* m_pa;
 		VertletPoint* m_pb;
 		
-		float m_length;
+		Real m_length;
+		/* Inverse stiffness for the Xpbd solver, a stick stretched by d pulls its points back at d / m_compliance
+		 * pixels per frame squared, 0 is rigid, ignored by the Pbd solver */
+		Real m_compliance;
 		bool m_hidden;
+		/* Stretched past the tear ratio, removed at the end of the update */
+		bool m_torn;
 
-		VertletStick(VertletPoint* pa, VertletPoint* pb, const float length, const bool hidden = false);
+		VertletStick(VertletPoint* pa, VertletPoint* pb, const Real length, const bool hidden = false, const Real compliance = 0);
 
 		bool ReplacePoint(VertletPoint* old_point, VertletPoint*  new_point);
 	};
 
+	/**
+	 * \brief Grid cell drawn filled, four sticks of the owning body given as indices into its m_sticks
+	 *
+	 * The sticks run top left to top right, top left to bottom left, bottom left to bottom right and top right to
+	 * bottom right. The cell is drawn while all four still share their corners, so a cut or tear through it hides it.
+	 */
+	struct VertletCell
+	{
+		uint32_t m_top;
+		uint32_t m_left;
+		uint32_t m_bottom;
+		uint32_t m_right;
+		/* Texture coordinates of the top left and bottom right corners */
+		float m_u0;
+		float m_v0;
+		float m_u1;
+		float m_v1;
+	};
+
+	/**
+	 * \brief Circle to draw for a visible point
+	 */
+	struct SnapshotPoint
+	{
+		float m_x;
+		float m_y;
+		float m_radius;
+		bool m_touched;
+	};
+
+	/**
+	 * \brief Fluid particle position
+	 */
+	struct SnapshotParticle
+	{
+		float m_x;
+		float m_y;
+	};
+
+	/**
+	 * \brief Triangles of one body's cells, a range of VertletSnapshot::m_mesh_positions drawn as one batch
+	 */
+	struct SnapshotMesh
+	{
+		uint32_t m_first;
+		uint32_t m_count;
+	};
+
+	/**
+	 * \brief Render ready copy of the simulation, lets drawing run while the solver works on the next step
+	 */
+	struct VertletSnapshot
+	{
+		uint64_t m_step{ 0 };
+		/* Quality level the step ran at and its measured cost */
+		int32_t m_quality_level{ 0 };
+		double m_step_ms{ 0 };
+		/* Visible sticks in pixel coordinates, drawn as one DrawLines batch */
+		std::vector<olc::LineSegment> m_lines;
+		std::vector<SnapshotPoint> m_points;
+		std::vector<SnapshotParticle> m_particles;
+		/* Intact cells as triangles, three vertices each with matching texture coordinates */
+		std::vector<olc::vf2d> m_mesh_positions;
+		std::vector<olc::vf2d> m_mesh_uvs;
+		std::vector<SnapshotMesh> m_meshes;
+		/* Sticks bordering intact cells, only drawn when cloth is drawn as wireframe */
+		std::vector<olc::LineSegment> m_mesh_lines;
+
+		void Clear()
+		{
+			m_lines.clear();
+			m_points.clear();
+			m_particles.clear();
+			m_mesh_positions.clear();
+			m_mesh_uvs.clear();
+			m_meshes.clear();
+			m_mesh_lines.clear();
+		}
+	};
+
+	/* Snapshots with fewer lines or triangles than this draw them on the calling thread only */
+	const size_t g_render_band_min_primitives = 2048;
+
+	/* How cells are drawn */
+	enum class ClothRender : uint8_t
+	{
+		/* Sticks only */
+		Wireframe,
+		/* Filled on the CPU into the draw target */
+		Filled,
+		/* Filled by the GPU, one triangle list decal per body */
+		Decal
+	};
+
+	/**
+	 * \brief How RenderSnapshot draws, none of the pointers are owned
+	 */
+	struct VertletRenderOptions
+	{
+		ClothRender m_cloth{ ClothRender::Wireframe };
+		/* Cloth texture for Filled, null for flat m_cloth_tint */
+		olc::Sprite* m_cloth_sprite{ nullptr };
+		/* Cloth texture for Decal, null for flat m_cloth_tint */
+		olc::Decal* m_cloth_decal{ nullptr };
+		olc::Pixel m_cloth_tint{ olc::WHITE };
+		/* Workers to split CPU drawing into screen bands across, null draws everything on the calling thread */
+		ParallelPool* m_pool{ nullptr };
+	};
+
+	/**
+	 * \brief Draws a snapshot, defined in VertletRender.cpp
+	 * \param renderer PixelGameEngine game pointer
+	 * \param snapshot Snapshot to draw
+	 * \param options Cloth style and threading
+	 */
+	void RenderSnapshot(olc::PixelGameEngine* renderer, const VertletSnapshot& snapshot, const VertletRenderOptions& options = VertletRenderOptions());
+
 	/**
 	 * \brief Structure comprised of some arrangement of VertletPoints & VertletSticks, update and render functions
 	 */
@@ -85,44 +290,225 @@ namespace VertletPhysics
 
 		std::vector<VertletPoint*> m_points;
 		std::vector<VertletStick*> m_sticks;
+		/* Filled cells, kept in step with m_sticks when torn sticks are removed */
+		std::vector<VertletCell> m_cells;
 
 		/**
-		 * \brief Updates the points and sticks
+		 * \brief Updates the points and sticks. Points and sticks are always visited in container order, so with
+		 * VERTLET_FIXED_POINT defined the same input produces bit identical output on every machine
 		 * \param screen_width Width of the game screen
 		 * \param screen_height Height of the game screen
 		 * \param mouse_dir Direction the mouse is moving since last frame
 		 * \param mouse_pos Current position of the mouse
+		 * \param cut_pressed Whether touched points are cut
+		 * \param settings Simulation parameters of the owning world
+		 * \param frames Frames of time this update covers, more than 1 for bodies stepped at a reduced rate
 		 */
-		void Update(const int32_t screen_width, const int32_t screen_height, const olc::vf2d mouse_dir = { 0, 0 }, const olc::vf2d mouse_pos = { 0, 0 }, const bool cut_pressed = false);
+		void Update(const int32_t screen_width, const int32_t screen_height, const olc::vf2d mouse_dir = { 0, 0 }, const olc::vf2d mouse_pos = { 0, 0 }, const bool cut_pressed = false, const VertletSettings& settings = VertletSettings(), const int32_t frames = 1);
 
 		/**
-		 * \brief Draws the physics bodies to the screen
+		 * \brief Draws the physics bodies to the screen, defined in VertletRender.cpp so the solver links without the engine
 		 * \param renderer PixelGameEngine game pointer
 		 */
 		void Render(olc::PixelGameEngine* renderer);
+
+		/**
+		 * \brief Appends what Render would draw to a snapshot
+		 * \param out Snapshot to append to
+		 * \param allow_points False to skip points even if the body draws them
+		 */
+		void WriteSnapshot(VertletSnapshot& out, const bool allow_points = true) const;
 				
 		void AddPoint(VertletPoint* new_point);		
 
+		/*
+		 * Creates a body of the same type and parameters around new points and sticks given in m_points order.
+		 * stick_index maps each of the original m_sticks to its index in sticks, UINT32_MAX if it was left out, and
+		 * is empty if none was left out.
+		 */
+		using Factory = std::function<VertletBody*(std::vector<VertletPoint*>& points, std::vector<VertletStick*>& sticks, const std::vector<uint32_t>& stick_index)>;
+
+		/**
+		 * \brief Factory for copies of this body, used by prototypes
+		 */
+		virtual Factory CopyFactory() const;
+
+		/* Bumped whenever a cut or tear changes the points or sticks */
+		uint64_t Revision() const { return m_revision; }
+
+		/**
+		 * \brief Box around every point as of the last Update
+		 * \return False if the body hasn't been updated yet or has no points
+		 */
+		bool Bounds(olc::vf2d& out_min, olc::vf2d& out_max) const;
+
+		/* Update rate scheduling, owned by the world stepping the body */
+		VertletLod m_lod;
+
+		/**
+		 * \brief Picks the update kernels compiled for a set of features, the body starts with every feature it can use
+		 * \param policy VertletPolicy flags, pins are kept regardless if any point is pinned
+		 */
+		void SetPolicy(const uint8_t policy);
+
+		/* VertletPolicy flags of the kernels in use */
+		uint8_t Policy() const { return m_policy; }
+
+	protected:
+		/**
+		 * \brief One constraint pass, run constrain loops times per substep
+		 * \param settings Simulation parameters
+		 * \return Number of sticks newly torn
+		 */
+		virtual size_t SolveConstraints(const VertletSettings& settings);
+
+		/**
+		 * \brief Solves some of the sticks once, for bodies that split the stick pass up, safe to run concurrently on
+		 * stick sets that share no point
+		 * \param sticks Sticks to solve in order
+		 * \param count Number of sticks
+		 * \param settings Solver and tear ratio
+		 * \return Number of sticks newly torn
+		 */
+		size_t SolveSticks(VertletStick* const* sticks, const size_t count, const VertletSettings& settings) const;
+
 	private:
+		/**
+		 * \brief Update passes compiled for one policy
+		 */
+		struct Kernels
+		{
+			void (VertletBody::*m_update_points)(const olc::vf2d, const olc::vf2d, const bool, const bool, const Real, const VertletSettings&);
+			size_t (VertletBody::*m_update_sticks)(const VertletSettings&);
+			void (VertletBody::*m_constrain_points)(const int32_t, const int32_t, const VertletSettings&);
+		};
+
+		/* Indexed by policy */
+		static const Kernels s_kernels[g_policy_count];
+
+		template <uint8_t Policy>
+		static constexpr Kernels KernelsFor();
+
+		uint8_t m_policy{ PolicyAll };
+		Kernels m_kernels{};
+
+		/* Length of the last step in frames, velocity is stored relative to it */
+		Real m_step_scale{ 1 };
+
+		uint64_t m_revision{ 0 };
+
+		olc::vf2d m_bounds_min{ 0, 0 };
+		olc::vf2d m_bounds_max{ 0, 0 };
+		bool m_has_bounds{ false };
+
+		/* Force field working arrays, kept between updates */
+		ForceFieldScratch m_force_scratch;
+
+		/* New index of each stick kept by RemoveTornSticks, for remapping cells */
+		std::vector<uint32_t> m_stick_remap;
+
+		/**
+		 * \brief Changes the step length, rescaling the stored velocity to match
+		 * \param step_scale Step length in frames
+		 */
+		void SetStepScale(const Real step_scale);
 
 		/**
-		 * \brief Update the points velocity
+		 * \brief Update the points velocity, force fields are evaluated for every point first
 		 * \param mouse_dir Direction the mouse is moving since last frame
 		 * \param mouse_pos Current position of the mouse
+		 * \param cut Whether touched points are cut
+		 * \param interact Whether the mouse affects points this step
+		 * \param step_scale Step length in frames
+		 * \param settings Simulation parameters
+		 * \tparam Pins False if no point is pinned
+		 * \tparam Interactive False to ignore the mouse
+		 */
+		template <bool Pins, bool Interactive>
+		void UpdatePoints(const olc::vf2d mouse_dir, const olc::vf2d mouse_pos, const bool cut, const bool interact, const Real step_scale, const VertletSettings& settings);
+
+		/**
+		 * \brief Adjusts the points to be stick length apart, sticks over the tear length are marked torn and left alone
+		 * \param settings Solver and tear ratio
+		 * \return Number of sticks newly torn
+		 * \tparam Pins False if no point is pinned
+		 */
+		template <bool Pins>
+		size_t UpdateSticks(const VertletSettings& settings);
+
+		/**
+		 * \brief Recomputes the box Bounds returns
 		 */
-		void UpdatePoints(const olc::vf2d mouse_dir = { 0, 0 }, const olc::vf2d mouse_pos = { 0, 0 }, const bool cut = false);
+		void UpdateBounds();
 
 		/**
-		 * \brief Adjusts the points to be stick length apart
+		 * \brief Deletes every torn stick in one pass, keeping the order of the rest, cells using a torn stick go with it
 		 */
-		void UpdateSticks();
+		void RemoveTornSticks();
 
 		/**
 		 * \brief Handles point screen bounds check and applies bounce
 		 * \param screen_width
 		 * \param screen_height
+		 * \param settings Simulation parameters
+		 * \tparam Pins False if no point is pinned
+		 * \tparam Bounded False to leave points anywhere, the pass does nothing
 		 */
-		void ConstrainPoints(const int32_t screen_width, const int32_t screen_height);
+		template <bool Pins, bool Bounded>
+		void ConstrainPoints(const int32_t screen_width, const int32_t screen_height, const VertletSettings& settings);
+	};
+
+	/**
+	 * \brief Body held to its rest shape by shape matching instead of stick iterations
+	 *
+	 * Each constraint pass finds the rotation that best fits the rest shape onto the current points, a closed
+	 * form 2x2 polar decomposition with no trig, and moves every point towards its fitted goal. One pass costs
+	 * O(n) and a stiffness of 1 gives a rigid body with no wobble regardless of the constrain loop count. Sticks
+	 * are kept for drawing only. With VERTLET_FIXED_POINT defined, rest shapes must stay under about 180 pixels
+	 * from their centre.
+	 *
+	 * Cuts have no visible effect: a cut point's copies join the rest shape where the point was, so the body
+	 * stays whole and rigid.
+	 */
+	class ShapeMatchBody : public VertletBody
+	{
+	public:
+		/**
+		 * \param points Points, their current positions become the rest shape
+		 * \param sticks Outline sticks, drawn but not solved
+		 * \param stiffness 0 - 1, share of the way to the goal moved per pass, 1 is rigid
+		 * \param _draw_points Whether points are drawn
+		 */
+		ShapeMatchBody(std::vector<VertletPoint*>& points, std::vector<VertletStick*>& sticks, const Real stiffness = 1, const bool _draw_points = false);
+
+		/**
+		 * \brief Creates the body with a known rest shape, e.g. from a prototype
+		 * \param rest_x Rest offsets from the rest centroid in points order, ignored if the size doesn't match
+		 * \param rest_y Rest offsets from the rest centroid in points order
+		 */
+		ShapeMatchBody(std::vector<VertletPoint*>& points, std::vector<VertletStick*>& sticks, const Real stiffness, const bool _draw_points, const std::vector<Real>& rest_x, const std::vector<Real>& rest_y);
+
+		Factory CopyFactory() const override;
+
+		Real Stiffness() const { return m_stiffness; }
+
+	protected:
+		size_t SolveConstraints(const VertletSettings& settings) override;
+
+	private:
+		/**
+		 * \brief Takes the current point positions as the rest shape
+		 */
+		void CaptureRestShape();
+
+		const Real m_stiffness;
+
+		/* Rest offsets from the rest centroid, indexed like m_shape_points */
+		std::vector<Real> m_rest_x;
+		std::vector<Real> m_rest_y;
+
+		/* m_points when the rest shape was taken, a cut changes m_points and the shape is retaken */
+		std::vector<VertletPoint*> m_shape_points;
 	};
 
 	/**
@@ -131,12 +517,12 @@ namespace VertletPhysics
 	 * \param pb Second point
 	 * \return Distance between
 	 */
-	static float Distance(const VertletPoint* pa, const VertletPoint* pb)
+	static Real Distance(const VertletPoint* pa, const VertletPoint* pb)
 	{
-		const float dx = pb->m_x - pa->m_x;
-		const float dy = pb->m_y - pa->m_y;
+		const Real dx = pb->m_x - pa->m_x;
+		const Real dy = pb->m_y - pa->m_y;
 
-		const float distance = sqrt(dx * dx + dy * dy);
+		const Real distance = Length(dx, dy);
 
 		return distance;
 	}
@@ -152,7 +538,7 @@ namespace VertletPhysics
 	 * \param draw_points Whether points are drawn, drawn if true
 	 * \return True if successfully created
 	 */
-	static bool CreateNet(std::vector<VertletBody*>& out_bodies, const float start_x, const float start_y, const int32_t len_x, const int32_t len_y, const float point_dist, const bool draw_points = false)
+	static bool CreateNet(std::vector<VertletBody*>& out_bodies, const Real start_x, const Real start_y, const int32_t len_x, const int32_t len_y, const Real point_dist, const bool draw_points = false)
 	{
 		std::vector<VertletPoint*> all_points;
 		std::vector<VertletStick*> all_sticks;
@@ -163,8 +549,8 @@ namespace VertletPhysics
 			for (auto x = 0; x < len_x; x++)
 			{
 				const bool pinned = y == 0;
-				const float pos_x = start_x + point_dist * x;
-				const float pos_y = start_y + point_dist * y;
+				const Real pos_x = start_x + point_dist * x;
+				const Real pos_y = start_y + point_dist * y;
 
 				auto* point = new VertletPoint(pos_x, pos_y, pos_x, pos_y, pinned, 5.f, draw_points);
 
@@ -172,6 +558,10 @@ namespace VertletPhysics
 			}
 		}
 
+		// stick index of the right and bottom stick leaving each point, for building cells
+		std::vector<uint32_t> right_sticks(all_points.size());
+		std::vector<uint32_t> btm_sticks(all_points.size());
+
 		// create sticks	
 		for (int32_t y = 0; y < len_y; y++)
 		{
@@ -186,6 +576,7 @@ namespace VertletPhysics
 					const int32_t start_point = x + len_x * y;
 					const int32_t end_point = (x + 1) + len_x * y;
 
+					right_sticks[start_point] = static_cast<uint32_t>(all_sticks.size());
 					all_sticks.emplace_back(new VertletStick(all_points[start_point], all_points[end_point], point_dist));
 				}
 
@@ -195,6 +586,7 @@ namespace VertletPhysics
 					const int32_t start_point = x + len_x * y;
 					const int32_t end_point = x + len_x * (y + 1);
 
+					btm_sticks[start_point] = static_cast<uint32_t>(all_sticks.size());
 					all_sticks.emplace_back(new VertletStick(all_points[start_point], all_points[end_point], point_dist));
 				}
 			}
@@ -204,6 +596,27 @@ namespace VertletPhysics
 		auto* body = new VertletBody(all_points, all_sticks, draw_points);
 		out_bodies.emplace_back(body);
 
+		// create cells, the texture spans the whole net
+		for (int32_t y = 0; y + 1 < len_y; y++)
+		{
+			for (int32_t x = 0; x + 1 < len_x; x++)
+			{
+				const int32_t top_left = x + len_x * y;
+
+				VertletCell cell;
+				cell.m_top = right_sticks[top_left];
+				cell.m_left = btm_sticks[top_left];
+				cell.m_bottom = right_sticks[top_left + len_x];
+				cell.m_right = btm_sticks[top_left + 1];
+				cell.m_u0 = static_cast<float>(x) / (len_x - 1);
+				cell.m_v0 = static_cast<float>(y) / (len_y - 1);
+				cell.m_u1 = static_cast<float>(x + 1) / (len_x - 1);
+				cell.m_v1 = static_cast<float>(y + 1) / (len_y - 1);
+
+				body->m_cells.push_back(cell);
+			}
+		}
+
 		return true;
 	}
 
@@ -214,7 +627,7 @@ namespace VertletPhysics
 	 * \param out_bodies Vec of physics body pointers
 	 * \return True if successfully created
 	 */
-	static bool CreateChain(const float x, const float y, std::vector<VertletBody*>& out_bodies)
+	static bool CreateChain(const Real x, const Real y, std::vector<VertletBody*>& out_bodies)
 	{
 		// create box points
 		auto* const p0 = new VertletPoint(x + 100, y + 100, x + 85, y + 95);
@@ -223,16 +636,15 @@ namespace VertletPhysics
 		auto* const p3 = new VertletPoint(x + 200, y + 100, x + 200, y + 100);
 		std::vector<VertletPoint*> box_points{ p0, p1, p2, p3 };
 
-		// Create box sticks
+		// Create box outline, shape matching holds the box rigid so no support stick is needed
 		auto* const s0 = new VertletStick(p0, p2, Distance(p0, p2));
 		auto* const s1 = new VertletStick(p2, p1, Distance(p2, p1));
 		auto* const s2 = new VertletStick(p1, p3, Distance(p1, p3));
 		auto* const s3 = new VertletStick(p3, p0, Distance(p3, p0));
-		auto* const s4 = new VertletStick(p3, p2, Distance(p3, p2), true); // support stick	
-		std::vector<VertletStick*> box_sticks{ s0, s1, s2, s3, s4 };
+		std::vector<VertletStick*> box_sticks{ s0, s1, s2, s3 };
 
-		// Create box body
-		auto* box = new VertletBody(box_points, box_sticks);
+		// Create box body, the box as placed is its rest shape
+		auto* box = new ShapeMatchBody(box_points, box_sticks);
 		out_bodies.emplace_back(box);
 
 		// Create chain points
@@ -253,81 +665,4 @@ namespace VertletPhysics
 
 		return true;
 	}
-	
-	/* Vertlet sample scene */
-	class VertletScene : public olc::PixelGameEngine
-	{
-	public:
-		VertletScene()
-		{			
-			sAppName = "Vertlet Scene";
-		}
-
-		bool OnUserCreate() override
-		{
-			return true;
-		}
-
-		bool OnUserUpdate(float fElapsedTime) override
-		{
-			// Determine mouse move direction	
-			const olc::vf2d current_mouse_pos = GetWindowMouse();
-			const olc::vf2d mouse_direction = last_mouse_pos - current_mouse_pos;
-			olc::vf2d mouse_direction_norm{ 0, 0 };
-
-			if (mouse_direction.x != 0 || mouse_direction.y != 0)
-			{
-				mouse_direction_norm = mouse_direction.norm();
-			}
-
-			// store last pos for next update
-			last_mouse_pos = current_mouse_pos;
-
-			// check should cut
-			const bool should_cut = GetMouse(0).bHeld;
-
-			// create or destroy objects in scene
-			if (GetKey(olc::Q).bPressed)
-			{
-				DestroyBodies();
-			}
-			else if (GetKey(olc::R).bPressed)
-			{
-				const auto x = rand() % 1000;
-
-				//CreateNet(m_bodies, x, 10, 80, 80, 5);
-
-				// release mode only
-				CreateNet(m_bodies, 10, 10, 250, 80, 5);
-			}
-
-			// Render scene
-			Clear(olc::VERY_DARK_CYAN);
-
-			for (auto& body : m_bodies)
-			{
-				body->Update(ScreenWidth(), ScreenHeight(), mouse_direction_norm, current_mouse_pos, should_cut);
-
-				body->Render(this);
-			}
-
-			return true;
-		}
-
-	private:
-
-		std::vector<VertletBody*> m_bodies;
-
-		olc::vi2d last_mouse_pos{ 0, 0 };
-
-		void DestroyBodies()
-		{
-			for (auto&& body : m_bodies)
-			{
-				delete body;
-			}
-
-			m_bodies.clear();
-		}
-	};
 }
\ No newline at end of file
@@ -0,0 +1,267 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+/*
+ * Per phase timers and per frame counters for the Vertlet pipeline
+ *
+ * Define VERTLET_PROFILING to compile them in, otherwise every VERTLET_PROFILE_ macro expands to nothing.
+ * Timers and counters accumulate into atomics from any thread, VERTLET_PROFILE_END_FRAME closes the
+ * frame into a lock-free ring that the scene can read at any time for a HUD or a CSV dump.
+ * Render runs on the engine thread at its own rate, so it has a profiler of its own closed by
+ * VERTLET_PROFILE_END_RENDER_FRAME instead of landing in whichever physics frame happens to be open.
+ */
+
+namespace VertletPhysics
+{
+	/* Timed sections of the pipeline, cut and force time is also counted in integrate as both happen inside the point pass */
+	enum class ProfilePhase : uint8_t
+	{
+		Integrate,
+		Sticks,
+		Bounds,
+		Cut,
+		Render,
+		Forces,
+		Fluid,
+		Count
+	};
+
+	/* Per frame counts */
+	enum class ProfileCounter : uint8_t
+	{
+		Points,
+		Sticks,
+		Cuts,
+		Allocations,
+		Tears,
+		/* Bodies that skipped a step for level of detail */
+		LodSkips,
+		Count
+	};
+
+	/**
+	 * \brief One closed frame of profiling data
+	 */
+	struct ProfileFrame
+	{
+		uint64_t m_frame{ 0 };
+		std::array<uint64_t, static_cast<size_t>(ProfilePhase::Count)> m_phase_ns{};
+		std::array<uint64_t, static_cast<size_t>(ProfileCounter::Count)> m_counters{};
+
+		uint64_t Time(const ProfilePhase phase) const { return m_phase_ns[static_cast<size_t>(phase)]; }
+		uint64_t Count(const ProfileCounter counter) const { return m_counters[static_cast<size_t>(counter)]; }
+	};
+
+	/**
+	 * \brief Accumulates the current frame and keeps a ring of closed frames
+	 */
+	class VertletProfiler
+	{
+	public:
+		/* Number of closed frames kept */
+		static constexpr size_t s_ring_size = 256;
+
+		/* Physics thread profiler */
+		static VertletProfiler& Get()
+		{
+			static VertletProfiler profiler;
+			return profiler;
+		}
+
+		/* Engine thread profiler, only the Render phase lands here */
+		static VertletProfiler& GetRender()
+		{
+			static VertletProfiler profiler;
+			return profiler;
+		}
+
+		/**
+		 * \brief Profiler a phase is timed into
+		 */
+		static VertletProfiler& For(const ProfilePhase phase)
+		{
+			return phase == ProfilePhase::Render ? GetRender() : Get();
+		}
+
+		void AddTime(const ProfilePhase phase, const uint64_t ns)
+		{
+			m_phase_ns[static_cast<size_t>(phase)].fetch_add(ns, std::memory_order_relaxed);
+		}
+
+		void AddCount(const ProfileCounter counter, const uint64_t value)
+		{
+			m_counters[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+		}
+
+		/**
+		 * \brief Moves the accumulated values into the ring and starts a new frame, single producer only
+		 */
+		void EndFrame()
+		{
+			const uint64_t frame = m_frames.load(std::memory_order_relaxed);
+			Slot& slot = m_ring[frame % s_ring_size];
+
+			// odd sequence marks the slot as being written
+			const uint32_t seq = slot.m_seq.load(std::memory_order_relaxed);
+			slot.m_seq.store(seq + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			slot.m_frame.store(frame, std::memory_order_relaxed);
+
+			for (size_t i = 0; i < m_phase_ns.size(); i++)
+			{
+				slot.m_phase_ns[i].store(m_phase_ns[i].exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+			}
+
+			for (size_t i = 0; i < m_counters.size(); i++)
+			{
+				slot.m_counters[i].store(m_counters[i].exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+			}
+
+			slot.m_seq.store(seq + 2, std::memory_order_release);
+			m_frames.store(frame + 1, std::memory_order_release);
+		}
+
+		/**
+		 * \brief Copies the most recent closed frames, safe to call from any thread
+		 * \param out Destination, newest frame first
+		 * \param max_frames Size of out
+		 * \return Number of frames copied
+		 */
+		size_t GetHistory(ProfileFrame* out, const size_t max_frames) const
+		{
+			const uint64_t frames = m_frames.load(std::memory_order_acquire);
+			const size_t available = static_cast<size_t>(frames < s_ring_size ? frames : s_ring_size);
+			size_t copied = 0;
+
+			for (size_t age = 0; age < available && copied < max_frames; age++)
+			{
+				const Slot& slot = m_ring[(frames - 1 - age) % s_ring_size];
+				ProfileFrame& frame = out[copied];
+
+				const uint32_t seq_before = slot.m_seq.load(std::memory_order_acquire);
+
+				frame.m_frame = slot.m_frame.load(std::memory_order_relaxed);
+				for (size_t i = 0; i < frame.m_phase_ns.size(); i++)
+				{
+					frame.m_phase_ns[i] = slot.m_phase_ns[i].load(std::memory_order_relaxed);
+				}
+				for (size_t i = 0; i < frame.m_counters.size(); i++)
+				{
+					frame.m_counters[i] = slot.m_counters[i].load(std::memory_order_relaxed);
+				}
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+
+				// skip slots the producer lapped while we were reading
+				if ((seq_before & 1) == 0 && slot.m_seq.load(std::memory_order_relaxed) == seq_before)
+				{
+					copied++;
+				}
+			}
+
+			return copied;
+		}
+
+		/**
+		 * \brief Writes the ring, oldest frame first, as CSV
+		 * \param path File to write
+		 * \return True if the file was written
+		 */
+		bool WriteCsv(const std::string& path) const
+		{
+			std::ofstream file(path);
+
+			if (!file)
+			{
+				return false;
+			}
+
+			static std::array<ProfileFrame, s_ring_size> history;
+			const size_t count = GetHistory(history.data(), history.size());
+
+			file << "frame,integrate_ns,sticks_ns,bounds_ns,cut_ns,render_ns,forces_ns,fluid_ns,points,sticks,cuts,allocations,tears,lod_skips\n";
+
+			for (size_t i = count; i-- > 0;)
+			{
+				const ProfileFrame& f = history[i];
+				file << f.m_frame;
+				for (const uint64_t ns : f.m_phase_ns)
+				{
+					file << ',' << ns;
+				}
+				for (const uint64_t value : f.m_counters)
+				{
+					file << ',' << value;
+				}
+				file << '\n';
+			}
+
+			return true;
+		}
+
+	private:
+		/**
+		 * \brief Ring entry guarded by a sequence counter, readers retry instead of locking
+		 */
+		struct Slot
+		{
+			std::atomic<uint32_t> m_seq{ 0 };
+			std::atomic<uint64_t> m_frame{ 0 };
+			std::array<std::atomic<uint64_t>, static_cast<size_t>(ProfilePhase::Count)> m_phase_ns{};
+			std::array<std::atomic<uint64_t>, static_cast<size_t>(ProfileCounter::Count)> m_counters{};
+		};
+
+		std::array<std::atomic<uint64_t>, static_cast<size_t>(ProfilePhase::Count)> m_phase_ns{};
+		std::array<std::atomic<uint64_t>, static_cast<size_t>(ProfileCounter::Count)> m_counters{};
+		std::array<Slot, s_ring_size> m_ring;
+		std::atomic<uint64_t> m_frames{ 0 };
+	};
+
+	/**
+	 * \brief Adds the lifetime of the scope to a phase
+	 */
+	class ProfileScope
+	{
+	public:
+		explicit ProfileScope(const ProfilePhase phase) : m_phase(phase), m_start(std::chrono::steady_clock::now()) {}
+
+		~ProfileScope()
+		{
+			const auto elapsed = std::chrono::steady_clock::now() - m_start;
+			VertletProfiler::For(m_phase).AddTime(m_phase, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+	private:
+		const ProfilePhase m_phase;
+		const std::chrono::steady_clock::time_point m_start;
+	};
+}
+
+#define VERTLET_PROFILE_CONCAT_INNER(A, B) A##B
+#define VERTLET_PROFILE_CONCAT(A, B) VERTLET_PROFILE_CONCAT_INNER(A, B)
+
+#ifdef VERTLET_PROFILING
+/* Time the rest of the enclosing scope */
+#define VERTLET_PROFILE_SCOPE(PHASE) const VertletPhysics::ProfileScope VERTLET_PROFILE_CONCAT(profile_scope_, __LINE__)(VertletPhysics::ProfilePhase::PHASE)
+/* Add to a per frame counter */
+#define VERTLET_PROFILE_COUNT(COUNTER, VALUE) VertletPhysics::VertletProfiler::Get().AddCount(VertletPhysics::ProfileCounter::COUNTER, static_cast<uint64_t>(VALUE))
+/* Close the current physics frame */
+#define VERTLET_PROFILE_END_FRAME() VertletPhysics::VertletProfiler::Get().EndFrame()
+/* Close the current render frame, engine thread only */
+#define VERTLET_PROFILE_END_RENDER_FRAME() VertletPhysics::VertletProfiler::GetRender().EndFrame()
+#else
+#define VERTLET_PROFILE_SCOPE(PHASE) ((void)0)
+#define VERTLET_PROFILE_COUNT(COUNTER, VALUE) ((void)0)
+#define VERTLET_PROFILE_END_FRAME() ((void)0)
+#define VERTLET_PROFILE_END_RENDER_FRAME() ((void)0)
+#endif
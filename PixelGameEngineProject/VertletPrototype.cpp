@@ -0,0 +1,141 @@
+#include "VertletPrototype.h"
+
+#include <unordered_map>
+
+namespace VertletPhysics
+{
+	VertletPrototype::VertletPrototype(const std::vector<VertletBody*>& bodies)
+	{
+		Capture capture;
+		CaptureBodies(bodies, capture);
+		*this = VertletPrototype(capture);
+	}
+
+	void VertletPrototype::CaptureBodies(const std::vector<VertletBody*>& bodies, Capture& out)
+	{
+		out.m_point_ids.clear();
+		out.m_points.clear();
+		out.m_sticks.clear();
+		out.m_bodies.clear();
+
+		for (const auto* body : bodies)
+		{
+			for (const auto* p : body->m_points)
+			{
+				out.m_point_ids.push_back(p);
+				out.m_points.push_back({ p->m_x, p->m_y, p->m_oldx, p->m_oldy, p->m_radius, 0, p->m_should_draw, p->m_pinned });
+			}
+
+			for (const auto* s : body->m_sticks)
+			{
+				out.m_sticks.push_back({ s->m_pa, s->m_pb, s->m_length, s->m_compliance, s->m_hidden });
+			}
+
+			out.m_bodies.push_back({ static_cast<uint32_t>(body->m_points.size()), static_cast<uint32_t>(body->m_sticks.size()), body->CopyFactory() });
+		}
+	}
+
+	VertletPrototype::VertletPrototype(const Capture& capture) :
+		m_points(capture.m_points)
+	{
+		// flatten points first so sticks can refer to points owned by any captured body
+		std::unordered_map<const VertletPoint*, uint32_t> point_index;
+		point_index.reserve(capture.m_point_ids.size());
+
+		for (size_t i = 0; i < capture.m_point_ids.size(); i++)
+		{
+			point_index.emplace(capture.m_point_ids[i], static_cast<uint32_t>(i));
+		}
+
+		uint32_t point_begin = 0;
+		size_t stick = 0;
+
+		for (const auto& body : capture.m_bodies)
+		{
+			BodyData data{};
+			data.m_point_begin = point_begin;
+			data.m_point_count = body.m_point_count;
+			data.m_stick_begin = static_cast<uint32_t>(m_sticks.size());
+			data.m_factory = body.m_factory;
+
+			const size_t first = stick;
+
+			for (const size_t end = stick + body.m_stick_count; stick < end; stick++)
+			{
+				const auto& s = capture.m_sticks[stick];
+				const auto a = point_index.find(s.m_a);
+				const auto b = point_index.find(s.m_b);
+
+				// sticks into bodies that were not captured can't be rebuilt, the factory is told where the rest went
+				if (a == point_index.end() || b == point_index.end())
+				{
+					if (data.m_stick_index.empty())
+					{
+						data.m_stick_index.resize(body.m_stick_count);
+
+						for (size_t kept = 0; kept < stick - first; kept++)
+						{
+							data.m_stick_index[kept] = static_cast<uint32_t>(kept);
+						}
+					}
+
+					data.m_stick_index[stick - first] = UINT32_MAX;
+					continue;
+				}
+
+				if (!data.m_stick_index.empty())
+				{
+					data.m_stick_index[stick - first] = static_cast<uint32_t>(m_sticks.size()) - data.m_stick_begin;
+				}
+
+				m_sticks.push_back({ a->second, b->second, s.m_length, s.m_compliance, s.m_hidden });
+				m_points[a->second].m_stick_count++;
+				m_points[b->second].m_stick_count++;
+			}
+
+			data.m_stick_count = static_cast<uint32_t>(m_sticks.size()) - data.m_stick_begin;
+			m_bodies.push_back(data);
+
+			point_begin += data.m_point_count;
+		}
+	}
+
+	bool VertletPrototype::Instantiate(std::vector<VertletBody*>& out_bodies, const Real offset_x, const Real offset_y) const
+	{
+		if (m_bodies.empty())
+		{
+			return false;
+		}
+
+		// instance points in prototype order, stick indices map straight onto this
+		std::vector<VertletPoint*> instance_points(m_points.size());
+
+		for (size_t i = 0; i < m_points.size(); i++)
+		{
+			const PointData& p = m_points[i];
+			auto* point = new VertletPoint(p.m_x + offset_x, p.m_y + offset_y, p.m_oldx + offset_x, p.m_oldy + offset_y, p.m_pinned, p.m_radius, p.m_should_draw);
+			point->m_attached_sticks.reserve(p.m_stick_count);
+			instance_points[i] = point;
+		}
+
+		out_bodies.reserve(out_bodies.size() + m_bodies.size());
+
+		for (const BodyData& body : m_bodies)
+		{
+			std::vector<VertletPoint*> points(instance_points.begin() + body.m_point_begin, instance_points.begin() + body.m_point_begin + body.m_point_count);
+
+			std::vector<VertletStick*> sticks;
+			sticks.reserve(body.m_stick_count);
+
+			for (uint32_t i = body.m_stick_begin; i < body.m_stick_begin + body.m_stick_count; i++)
+			{
+				const StickData& s = m_sticks[i];
+				sticks.push_back(new VertletStick(instance_points[s.m_a], instance_points[s.m_b], s.m_length, s.m_hidden, s.m_compliance));
+			}
+
+			out_bodies.emplace_back(body.m_factory(points, sticks, body.m_stick_index));
+		}
+
+		return true;
+	}
+}
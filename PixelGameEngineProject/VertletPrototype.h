@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "VertletPhysics.h"
+
+namespace VertletPhysics
+{
+	/**
+	 * \brief Flat copy of one or more bodies that can be stamped out at an offset without re-running the factory loops
+	 */
+	class VertletPrototype
+	{
+	public:
+		struct PointData
+		{
+			Real m_x;
+			Real m_y;
+			Real m_oldx;
+			Real m_oldy;
+			Real m_radius;
+			uint32_t m_stick_count;
+			bool m_should_draw;
+			bool m_pinned;
+		};
+
+		/**
+		 * \brief Plain copy of bodies with sticks still referring to points by address, cheap to take
+		 * while the bodies are live and safe to index later on another thread as the addresses are never followed
+		 */
+		struct Capture
+		{
+			struct StickData
+			{
+				const VertletPoint* m_a;
+				const VertletPoint* m_b;
+				Real m_length;
+				Real m_compliance;
+				bool m_hidden;
+			};
+
+			struct BodyData
+			{
+				uint32_t m_point_count;
+				uint32_t m_stick_count;
+				VertletBody::Factory m_factory;
+			};
+
+			/* Address of each captured point, parallel to m_points */
+			std::vector<const VertletPoint*> m_point_ids;
+			std::vector<PointData> m_points;
+			std::vector<StickData> m_sticks;
+			std::vector<BodyData> m_bodies;
+		};
+
+		VertletPrototype() = default;
+
+		/**
+		 * \brief Captures the bodies' points and sticks, sticks may link points of different captured bodies
+		 * \param bodies Bodies to capture, left untouched
+		 */
+		explicit VertletPrototype(const std::vector<VertletBody*>& bodies);
+
+		/**
+		 * \brief Builds the prototype from an earlier capture
+		 * \param capture Capture to index
+		 */
+		explicit VertletPrototype(const Capture& capture);
+
+		/**
+		 * \brief Copies the bodies without indexing them, the expensive part of building a prototype can then run elsewhere
+		 * \param bodies Bodies to capture, left untouched
+		 * \param out Capture to fill, reusing its storage
+		 */
+		static void CaptureBodies(const std::vector<VertletBody*>& bodies, Capture& out);
+
+		/**
+		 * \brief Creates a copy of the captured bodies, stick lengths are reused rather than recomputed
+		 * \param out_bodies Vec of vertlet body pointers
+		 * \param offset_x Translation applied to every point in x
+		 * \param offset_y Translation applied to every point in y
+		 * \return True if any bodies were created
+		 */
+		bool Instantiate(std::vector<VertletBody*>& out_bodies, const Real offset_x, const Real offset_y) const;
+
+		size_t PointCount() const { return m_points.size(); }
+		size_t StickCount() const { return m_sticks.size(); }
+
+		/* Approximate heap size of the captured data */
+		size_t MemoryBytes() const { return m_points.size() * sizeof(PointData) + m_sticks.size() * sizeof(StickData) + m_bodies.size() * sizeof(BodyData); }
+
+		/* Captured points in body order, instances create their points in the same order */
+		const std::vector<PointData>& Points() const { return m_points; }
+
+	private:
+		struct StickData
+		{
+			/* Indices into m_points, rebased onto the instance's points */
+			uint32_t m_a;
+			uint32_t m_b;
+			Real m_length;
+			Real m_compliance;
+			bool m_hidden;
+		};
+
+		struct BodyData
+		{
+			uint32_t m_point_begin;
+			uint32_t m_point_count;
+			uint32_t m_stick_begin;
+			uint32_t m_stick_count;
+			/* Captured stick order to index in the instance's sticks, empty if every stick was kept */
+			std::vector<uint32_t> m_stick_index;
+			/* Recreates the body with its type and parameters */
+			VertletBody::Factory m_factory;
+		};
+
+		std::vector<PointData> m_points;
+		std::vector<StickData> m_sticks;
+		std::vector<BodyData> m_bodies;
+	};
+}
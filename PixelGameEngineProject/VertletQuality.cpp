@@ -0,0 +1,83 @@
+#include "VertletQuality.h"
+
+namespace VertletPhysics
+{
+	/* Weight of the newest sample in the smoothed cost */
+	const double g_quality_smoothing = 0.1;
+	/* Lower quality when the smoothed cost exceeds this share of the budget */
+	const double g_quality_lower_at = 1.0;
+	/* Raise quality only when the predicted cost stays under this share of the budget */
+	const double g_quality_raise_at = 0.75;
+	/* Consecutive steps over budget before lowering */
+	const int32_t g_quality_lower_steps = 10;
+	/* Consecutive steps with headroom before raising */
+	const int32_t g_quality_raise_steps = 120;
+	/* Steps to let the cost settle after a change */
+	const int32_t g_quality_cooldown_steps = 30;
+
+	VertletQualityController::VertletQualityController(const double budget_ms) :
+		m_levels{
+			{ 1, 1, false },
+			{ 2, 1, false },
+			{ 3, 1, false },
+			{ 3, 1, true },	// matches g_constrain_loops
+			{ 4, 2, true },
+			{ 6, 2, true },
+			{ 8, 4, true } },
+		m_level(3),
+		m_budget_ms(budget_ms),
+		m_smoothed_ms(0),
+		m_over_steps(0),
+		m_under_steps(0),
+		m_cooldown(0),
+		m_last_decision(QualityDecision::Hold),
+		m_changes(0)
+	{}
+
+	QualityDecision VertletQualityController::Update(const double step_ms)
+	{
+		m_smoothed_ms = m_smoothed_ms == 0 ? step_ms : m_smoothed_ms + (step_ms - m_smoothed_ms) * g_quality_smoothing;
+		m_last_decision = QualityDecision::Hold;
+
+		if (m_cooldown > 0)
+		{
+			m_cooldown--;
+			return m_last_decision;
+		}
+
+		m_over_steps = m_smoothed_ms > m_budget_ms * g_quality_lower_at ? m_over_steps + 1 : 0;
+
+		// predict what the next level would cost from the work ratio
+		const bool can_raise = m_level + 1 < m_levels.size();
+		const double predicted_ms = can_raise ? m_smoothed_ms * Work(m_levels[m_level + 1]) / Work(m_levels[m_level]) : 0;
+		m_under_steps = can_raise && predicted_ms < m_budget_ms * g_quality_raise_at ? m_under_steps + 1 : 0;
+
+		if (m_over_steps >= g_quality_lower_steps && m_level > 0)
+		{
+			SetLevel(m_level - 1);
+			m_last_decision = QualityDecision::Lower;
+		}
+		else if (m_under_steps >= g_quality_raise_steps)
+		{
+			SetLevel(m_level + 1);
+			m_last_decision = QualityDecision::Raise;
+		}
+
+		return m_last_decision;
+	}
+
+	double VertletQualityController::Work(const VertletQuality& quality)
+	{
+		// one integrate pass plus the constrain loops, per substep
+		return static_cast<double>(quality.m_substeps) * (1 + quality.m_constrain_loops);
+	}
+
+	void VertletQualityController::SetLevel(const size_t level)
+	{
+		m_level = level;
+		m_over_steps = 0;
+		m_under_steps = 0;
+		m_cooldown = g_quality_cooldown_steps;
+		m_changes++;
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VertletPhysics
+{
+	/**
+	 * \brief Solver and render settings the quality controller can trade for speed
+	 */
+	struct VertletQuality
+	{
+		int32_t m_constrain_loops;
+		int32_t m_substeps;
+		bool m_draw_points;
+	};
+
+	/* What the controller did on its last update */
+	enum class QualityDecision : uint8_t
+	{
+		Hold,
+		Lower,
+		Raise
+	};
+
+	/**
+	 * \brief Moves along a ladder of quality levels to keep the measured step cost inside a budget
+	 *
+	 * Lowers quality after the smoothed cost has been over budget for a run of steps and only raises it again
+	 * once the next level's predicted cost fits under a lower threshold for a longer run, so it doesn't oscillate.
+	 */
+	class VertletQualityController
+	{
+	public:
+		/**
+		 * \param budget_ms Target cost of one step
+		 */
+		explicit VertletQualityController(const double budget_ms);
+
+		/**
+		 * \brief Feeds the cost of the last step and adjusts the level between steps
+		 * \param step_ms Measured cost of the last step
+		 * \return Decision taken
+		 */
+		QualityDecision Update(const double step_ms);
+
+		const VertletQuality& Quality() const { return m_levels[m_level]; }
+		int32_t Level() const { return static_cast<int32_t>(m_level); }
+		int32_t LevelCount() const { return static_cast<int32_t>(m_levels.size()); }
+		QualityDecision LastDecision() const { return m_last_decision; }
+		/* Number of level changes so far */
+		uint32_t Changes() const { return m_changes; }
+		double SmoothedMs() const { return m_smoothed_ms; }
+		double BudgetMs() const { return m_budget_ms; }
+
+	private:
+		/* Cheapest first */
+		std::vector<VertletQuality> m_levels;
+		size_t m_level;
+
+		const double m_budget_ms;
+		double m_smoothed_ms;
+
+		int32_t m_over_steps;
+		int32_t m_under_steps;
+		int32_t m_cooldown;
+
+		QualityDecision m_last_decision;
+		uint32_t m_changes;
+
+		/**
+		 * \brief Relative solver work of a level, used to predict the cost of the next level up
+		 */
+		static double Work(const VertletQuality& quality);
+
+		void SetLevel(const size_t level);
+	};
+}
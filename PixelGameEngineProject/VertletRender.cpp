@@ -0,0 +1,142 @@
+#include "VertletPhysics.h"
+#include "VertletParallel.h"
+
+namespace VertletPhysics
+{
+	/* Larger points are drawn with FillCircle instead of a cached stamp */
+	const int32_t g_render_max_stamp_radius = 64;
+
+	/**
+	 * \brief Draws a filled circle from a per thread cache of stamps, one per radius, rasterized on first use
+	 */
+	static void DrawPoint(olc::PixelGameEngine* renderer, const float x, const float y, const float radius, const olc::Pixel colour)
+	{
+		static thread_local std::vector<olc::Stamp> stamps;
+
+		// same truncation FillCircle's int parameters apply
+		const int32_t r = static_cast<int32_t>(radius);
+
+		if (r < 0 || r > g_render_max_stamp_radius)
+		{
+			renderer->FillCircle(x, y, radius, colour);
+			return;
+		}
+
+		if (static_cast<size_t>(r) >= stamps.size())
+		{
+			stamps.resize(r + 1);
+		}
+
+		if (stamps[r].IsEmpty())
+		{
+			stamps[r] = olc::Stamp::Circle(r);
+		}
+
+		renderer->DrawStamp(static_cast<int32_t>(x), static_cast<int32_t>(y), stamps[r], colour);
+	}
+
+	void VertletBody::Render(olc::PixelGameEngine* renderer)
+	{
+		VERTLET_PROFILE_SCOPE(Render);
+
+		// render points
+		for (const auto& p : m_points)
+		{
+			if (p->m_should_draw && draw_points)
+			{
+				const auto colour = p->m_touched ? olc::RED : olc::WHITE;
+				const auto radius = p->m_touched ? p->m_radius * 3 : p->m_radius;
+				DrawPoint(renderer, ToFloat(p->m_x), ToFloat(p->m_y), ToFloat(radius), colour);
+			}
+		}
+
+		// render sticks, gathered so they are clipped and drawn as one batch
+		static thread_local std::vector<olc::LineSegment> lines;
+		lines.clear();
+
+		for (const auto& s : m_sticks)
+		{
+			if (!s->m_hidden)
+			{
+				lines.push_back({ static_cast<int32_t>(ToFloat(s->m_pa->m_x)), static_cast<int32_t>(ToFloat(s->m_pa->m_y)),
+					static_cast<int32_t>(ToFloat(s->m_pb->m_x)), static_cast<int32_t>(ToFloat(s->m_pb->m_y)) });
+			}
+		}
+
+		renderer->DrawLines(lines.data(), lines.size());
+	}
+
+	/**
+	 * \brief Runs draw once per screen band on the pool, or once for the whole screen if the work is too small to split
+	 * \param draw Called with the [top, bottom) rows to draw, calls for different bands must touch disjoint pixels
+	 */
+	template <typename DrawFunction>
+	static void DrawInBands(olc::PixelGameEngine* renderer, ParallelPool* pool, const size_t work, const DrawFunction& draw)
+	{
+		const size_t bands = pool != nullptr ? pool->Workers() + 1 : 1;
+
+		if (bands == 1 || work < g_render_band_min_primitives)
+		{
+			draw(0, renderer->GetDrawTargetHeight());
+			return;
+		}
+
+		const int32_t band_height = (renderer->GetDrawTargetHeight() + static_cast<int32_t>(bands) - 1) / static_cast<int32_t>(bands);
+
+		pool->For(bands, 1, [&](const size_t begin, const size_t end)
+		{
+			for (size_t band = begin; band < end; band++)
+			{
+				const int32_t top = static_cast<int32_t>(band) * band_height;
+				draw(top, top + band_height);
+			}
+		});
+	}
+
+	void RenderSnapshot(olc::PixelGameEngine* renderer, const VertletSnapshot& snapshot, const VertletRenderOptions& options)
+	{
+		VERTLET_PROFILE_SCOPE(Render);
+
+		if (options.m_cloth == ClothRender::Filled && !snapshot.m_mesh_positions.empty())
+		{
+			// every body's triangles in one pass, bodies later in the snapshot draw on top as with sticks
+			DrawInBands(renderer, options.m_pool, snapshot.m_mesh_positions.size() / 3, [&](const int32_t top, const int32_t bottom)
+			{
+				renderer->FillTriangles(snapshot.m_mesh_positions.data(), snapshot.m_mesh_uvs.data(), snapshot.m_mesh_positions.size(),
+					options.m_cloth_sprite, options.m_cloth_tint, top, bottom);
+			});
+		}
+		else if (options.m_cloth == ClothRender::Decal)
+		{
+			// decals are drawn over the draw target once the frame ends
+			for (const auto& mesh : snapshot.m_meshes)
+			{
+				renderer->DrawTrianglesDecal(options.m_cloth_decal, snapshot.m_mesh_positions.data() + mesh.m_first, snapshot.m_mesh_uvs.data() + mesh.m_first,
+					mesh.m_count, options.m_cloth_tint);
+			}
+		}
+
+		for (const auto& p : snapshot.m_points)
+		{
+			DrawPoint(renderer, p.m_x, p.m_y, p.m_radius, p.m_touched ? olc::RED : olc::WHITE);
+		}
+
+		const bool wireframe = options.m_cloth == ClothRender::Wireframe;
+
+		// every band clips the whole batch to its own rows, so bands never write the same pixel
+		DrawInBands(renderer, options.m_pool, snapshot.m_lines.size() + (wireframe ? snapshot.m_mesh_lines.size() : 0), [&](const int32_t top, const int32_t bottom)
+		{
+			renderer->DrawLines(snapshot.m_lines.data(), snapshot.m_lines.size(), olc::WHITE, top, bottom);
+
+			if (wireframe)
+			{
+				renderer->DrawLines(snapshot.m_mesh_lines.data(), snapshot.m_mesh_lines.size(), olc::WHITE, top, bottom);
+			}
+		});
+
+		for (const auto& p : snapshot.m_particles)
+		{
+			renderer->FillRect(static_cast<int32_t>(p.m_x) - 1, static_cast<int32_t>(p.m_y) - 1, 2, 2, olc::CYAN);
+		}
+	}
+}
@@ -0,0 +1,562 @@
+#include "VertletRewind.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace VertletPhysics
+{
+	/**
+	 * \brief Position in rewind steps
+	 */
+	static int32_t Quantise(const Real value)
+	{
+		return static_cast<int32_t>(std::lround(ToFloat(value) * g_rewind_scale));
+	}
+
+	static Real Dequantise(const int32_t value)
+	{
+		return Real(static_cast<float>(value) / g_rewind_scale);
+	}
+
+	/**
+	 * \brief Appends bits most significant first
+	 */
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+		void Write(const uint32_t value, int32_t bits)
+		{
+			while (bits > 0)
+			{
+				const int32_t take = std::min(bits, 8 - m_used);
+				const uint32_t chunk = (value >> (bits - take)) & ((1u << take) - 1);
+
+				m_byte = static_cast<uint8_t>(m_byte | (chunk << (8 - m_used - take)));
+				m_used += take;
+				bits -= take;
+
+				if (m_used == 8)
+				{
+					m_out.push_back(m_byte);
+					m_byte = 0;
+					m_used = 0;
+				}
+			}
+		}
+
+		/* Pads the last byte with zeros */
+		void Flush()
+		{
+			if (m_used > 0)
+			{
+				m_out.push_back(m_byte);
+				m_byte = 0;
+				m_used = 0;
+			}
+		}
+
+	private:
+		std::vector<uint8_t>& m_out;
+		uint8_t m_byte{ 0 };
+		int32_t m_used{ 0 };
+	};
+
+	/**
+	 * \brief Reads bits written by BitWriter
+	 */
+	class BitReader
+	{
+	public:
+		explicit BitReader(const uint8_t* in) : m_in(in) {}
+
+		uint32_t Read(int32_t bits)
+		{
+			uint32_t value = 0;
+
+			while (bits > 0)
+			{
+				const int32_t take = std::min(bits, 8 - m_used);
+				const uint32_t chunk = (static_cast<uint32_t>(*m_in) >> (8 - m_used - take)) & ((1u << take) - 1);
+
+				value = (value << take) | chunk;
+				m_used += take;
+				bits -= take;
+
+				if (m_used == 8)
+				{
+					m_in++;
+					m_used = 0;
+				}
+			}
+
+			return value;
+		}
+
+		/* Counts and consumes zero bits up to the next one, which is left unread */
+		int32_t ReadZeros()
+		{
+			int32_t zeros = 0;
+
+			for (;;)
+			{
+				const uint8_t rest = static_cast<uint8_t>(*m_in << m_used);
+
+				if (rest != 0)
+				{
+					// leading zeros of the unread part of this byte
+					int32_t lead = 0;
+					while ((rest & (0x80 >> lead)) == 0)
+					{
+						lead++;
+					}
+
+					m_used += lead;
+					return zeros + lead;
+				}
+
+				zeros += 8 - m_used;
+				m_in++;
+				m_used = 0;
+			}
+		}
+
+	private:
+		const uint8_t* m_in;
+		int32_t m_used{ 0 };
+	};
+
+	/**
+	 * \brief Elias gamma code of value + 1, one bit for zero and three for one or two
+	 */
+	static void WriteGamma(BitWriter& out, const uint32_t value)
+	{
+		const uint32_t v = value + 1;
+		int32_t bits = 0;
+
+		while ((v >> bits) > 1)
+		{
+			bits++;
+		}
+
+		out.Write(0, bits);
+		out.Write(v, bits + 1);
+	}
+
+	static uint32_t ReadGamma(BitReader& in)
+	{
+		const int32_t bits = in.ReadZeros();
+		return in.Read(bits + 1) - 1;
+	}
+
+	/**
+	 * \brief Codes one axis of a frame against the constant velocity prediction and moves the history along
+	 * \param out Coded bits are appended here
+	 * \param values Quantised positions of this frame
+	 * \param prev Previous frame, becomes this frame
+	 * \param prev2 Frame before that, becomes the previous frame
+	 */
+	static void EncodeAxis(BitWriter& out, const std::vector<int32_t>& values, std::vector<int32_t>& prev, std::vector<int32_t>& prev2)
+	{
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			const int32_t residual = values[i] - (2 * prev[i] - prev2[i]);
+
+			prev2[i] = prev[i];
+			prev[i] = values[i];
+
+			// zig-zag so small residuals of either sign get the short codes
+			WriteGamma(out, (static_cast<uint32_t>(residual) << 1) ^ static_cast<uint32_t>(residual >> 31));
+		}
+	}
+
+	/**
+	 * \brief Reverse of EncodeAxis
+	 * \param in Coded bits, moved past the axis
+	 * \param prev Previous frame, becomes this frame
+	 * \param prev2 Frame before that, becomes the previous frame
+	 */
+	static void DecodeAxis(BitReader& in, std::vector<int32_t>& prev, std::vector<int32_t>& prev2)
+	{
+		for (size_t i = 0; i < prev.size(); i++)
+		{
+			const uint32_t zigzag = ReadGamma(in);
+			const int32_t residual = static_cast<int32_t>(zigzag >> 1) ^ -static_cast<int32_t>(zigzag & 1);
+			const int32_t value = 2 * prev[i] - prev2[i] + residual;
+
+			prev2[i] = prev[i];
+			prev[i] = value;
+		}
+	}
+
+	size_t VertletRewind::Segment::Bytes() const
+	{
+		return sizeof(Segment) + m_topology_bytes + m_data.capacity() + m_offsets.capacity() * sizeof(uint32_t) + m_key_x.capacity() * sizeof(Real) * 4;
+	}
+
+	VertletRewind::VertletRewind(const size_t max_frames, const size_t max_bytes) :
+		m_max_frames(max_frames),
+		m_max_bytes(max_bytes)
+	{
+		for (auto& frame : m_pool)
+		{
+			m_free.Push(&frame);
+		}
+
+		m_worker = std::thread([this]() { WorkerLoop(); });
+	}
+
+	VertletRewind::~VertletRewind()
+	{
+		m_running = false;
+		m_wake.notify_one();
+		m_worker.join();
+	}
+
+	void VertletRewind::Record(const std::vector<VertletBody*>& bodies, const uint64_t step, const bool topology_changed)
+	{
+		PendingFrame* frame = nullptr;
+
+		// worker is behind, skip the frame rather than wait, the gap needs a fresh keyframe after it
+		if (!m_free.Pop(frame))
+		{
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+			m_force_keyframe = true;
+			return;
+		}
+
+		const bool need_topology = topology_changed || m_force_keyframe || m_need_keyframe.exchange(false);
+
+		frame->m_step = step;
+		frame->m_epoch = m_epoch.load(std::memory_order_relaxed);
+		frame->m_keyframe = need_topology || m_since_keyframe >= g_rewind_keyframe_interval;
+		frame->m_has_topology = need_topology;
+		frame->m_x.clear();
+		frame->m_y.clear();
+		frame->m_oldx.clear();
+		frame->m_oldy.clear();
+
+		if (need_topology)
+		{
+			VertletPrototype::CaptureBodies(bodies, frame->m_capture);
+		}
+
+		for (const auto* body : bodies)
+		{
+			for (const auto* p : body->m_points)
+			{
+				frame->m_x.push_back(p->m_x);
+				frame->m_y.push_back(p->m_y);
+
+				if (frame->m_keyframe)
+				{
+					frame->m_oldx.push_back(p->m_oldx);
+					frame->m_oldy.push_back(p->m_oldy);
+				}
+			}
+		}
+
+		m_since_keyframe = frame->m_keyframe ? 1 : m_since_keyframe + 1;
+		m_force_keyframe = false;
+
+		m_to_worker.Push(frame);
+		m_wake.notify_one();
+	}
+
+	void VertletRewind::WorkerLoop()
+	{
+		while (m_running.load())
+		{
+			PendingFrame* frame = nullptr;
+
+			while (m_to_worker.Pop(frame))
+			{
+				Encode(*frame);
+				m_free.Push(frame);
+			}
+
+			// the timeout covers a notify landing between the empty check and the wait
+			std::unique_lock<std::mutex> lock(m_wake_mutex);
+			m_wake.wait_for(lock, std::chrono::milliseconds(5));
+		}
+	}
+
+	void VertletRewind::Encode(PendingFrame& frame)
+	{
+		const size_t count = frame.m_x.size();
+
+		if (frame.m_keyframe)
+		{
+			Segment segment;
+			segment.m_first_step = frame.m_step;
+			segment.m_key_x = frame.m_x;
+			segment.m_key_y = frame.m_y;
+			segment.m_key_oldx = frame.m_oldx;
+			segment.m_key_oldy = frame.m_oldy;
+
+			if (frame.m_has_topology)
+			{
+				// the costly part of a keyframe, kept off the simulation thread
+				segment.m_topology = std::make_shared<const VertletPrototype>(frame.m_capture);
+				segment.m_topology_bytes = segment.m_topology->MemoryBytes();
+			}
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (frame.m_epoch != m_epoch.load())
+			{
+				return;
+			}
+
+			if (!segment.m_topology)
+			{
+				// same topology as the open segment, unless that was lost to a truncate or dropped frame
+				if (!m_coding || m_coding_epoch != frame.m_epoch || m_segments.empty() || m_segments.back().m_topology->Points().size() != count)
+				{
+					m_coding = false;
+					m_need_keyframe = true;
+					return;
+				}
+
+				segment.m_topology = m_segments.back().m_topology;
+			}
+
+			m_prev_x.resize(count);
+			m_prev_y.resize(count);
+			m_prev2_x.resize(count);
+			m_prev2_y.resize(count);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				m_prev_x[i] = Quantise(frame.m_x[i]);
+				m_prev_y[i] = Quantise(frame.m_y[i]);
+				m_prev2_x[i] = Quantise(frame.m_oldx[i]);
+				m_prev2_y[i] = Quantise(frame.m_oldy[i]);
+			}
+
+			m_coding = true;
+			m_coding_epoch = frame.m_epoch;
+
+			m_bytes += segment.Bytes();
+			m_frames += 1;
+			m_segments.push_back(std::move(segment));
+			Evict();
+			return;
+		}
+
+		// deltas need the open segment they were predicted from
+		if (!m_coding || m_coding_epoch != frame.m_epoch || m_prev_x.size() != count)
+		{
+			m_coding = false;
+			m_need_keyframe = true;
+			return;
+		}
+
+		std::vector<int32_t> quantised(count);
+
+		m_code.clear();
+		BitWriter writer(m_code);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			quantised[i] = Quantise(frame.m_x[i]);
+		}
+		EncodeAxis(writer, quantised, m_prev_x, m_prev2_x);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			quantised[i] = Quantise(frame.m_y[i]);
+		}
+		EncodeAxis(writer, quantised, m_prev_y, m_prev2_y);
+		writer.Flush();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (frame.m_epoch != m_epoch.load() || m_segments.empty())
+		{
+			m_coding = false;
+			return;
+		}
+
+		Segment& segment = m_segments.back();
+		const size_t bytes_before = segment.Bytes();
+
+		segment.m_offsets.push_back(static_cast<uint32_t>(segment.m_data.size()));
+		segment.m_data.insert(segment.m_data.end(), m_code.begin(), m_code.end());
+
+		m_bytes += segment.Bytes() - bytes_before;
+		m_frames += 1;
+		Evict();
+	}
+
+	void VertletRewind::Evict()
+	{
+		// whole segments only, deltas can't be decoded without their keyframe
+		while (m_segments.size() > 1)
+		{
+			const Segment& oldest = m_segments.front();
+			const bool over_frames = m_frames - oldest.Frames() >= m_max_frames;
+			const bool over_bytes = m_bytes > m_max_bytes;
+
+			if (!over_frames && !over_bytes)
+			{
+				break;
+			}
+
+			m_frames -= oldest.Frames();
+			m_bytes -= oldest.Bytes();
+			m_segments.pop_front();
+		}
+	}
+
+	bool VertletRewind::Restore(const uint64_t step, const bool prefer_earlier, std::vector<VertletBody*>& out_bodies, uint64_t& out_step) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// skipped or discarded frames leave steps between segments that were never recorded, those snap to the
+		// closest recorded step on the preferred side so scrubbing across a hole keeps moving
+		const Segment* found = nullptr;
+		const Segment* before = nullptr;
+		const Segment* after = nullptr;
+
+		for (const Segment& segment : m_segments)
+		{
+			if (step >= segment.m_first_step && step <= segment.LastStep())
+			{
+				found = &segment;
+				break;
+			}
+
+			if (segment.LastStep() < step)
+			{
+				before = &segment;
+			}
+			else if (after == nullptr)
+			{
+				after = &segment;
+			}
+		}
+
+		uint64_t restored_step = step;
+
+		if (found == nullptr)
+		{
+			const bool use_before = before != nullptr && (prefer_earlier || after == nullptr);
+
+			if (!use_before && after == nullptr)
+			{
+				return false;
+			}
+
+			found = use_before ? before : after;
+			restored_step = use_before ? before->LastStep() : after->m_first_step;
+		}
+
+		const Segment& segment = *found;
+		const size_t first_body = out_bodies.size();
+		segment.m_topology->Instantiate(out_bodies, 0, 0);
+
+		const size_t count = segment.m_key_x.size();
+		const size_t frame = static_cast<size_t>(restored_step - segment.m_first_step);
+
+		std::vector<Real> x = segment.m_key_x;
+		std::vector<Real> y = segment.m_key_y;
+		std::vector<Real> oldx = segment.m_key_oldx;
+		std::vector<Real> oldy = segment.m_key_oldy;
+
+		if (frame > 0)
+		{
+			std::vector<int32_t> prev_x(count), prev_y(count), prev2_x(count), prev2_y(count);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				prev_x[i] = Quantise(x[i]);
+				prev_y[i] = Quantise(y[i]);
+				prev2_x[i] = Quantise(oldx[i]);
+				prev2_y[i] = Quantise(oldy[i]);
+			}
+
+			for (size_t f = 0; f < frame; f++)
+			{
+				BitReader reader(segment.m_data.data() + segment.m_offsets[f]);
+				DecodeAxis(reader, prev_x, prev2_x);
+				DecodeAxis(reader, prev_y, prev2_y);
+			}
+
+			for (size_t i = 0; i < count; i++)
+			{
+				x[i] = Dequantise(prev_x[i]);
+				y[i] = Dequantise(prev_y[i]);
+				oldx[i] = Dequantise(prev2_x[i]);
+				oldy[i] = Dequantise(prev2_y[i]);
+			}
+		}
+
+		// instances create points in capture order
+		size_t i = 0;
+		for (size_t b = first_body; b < out_bodies.size(); b++)
+		{
+			for (auto* p : out_bodies[b]->m_points)
+			{
+				p->m_x = x[i];
+				p->m_y = y[i];
+				p->m_oldx = oldx[i];
+				p->m_oldy = oldy[i];
+				i++;
+			}
+		}
+
+		out_step = restored_step;
+		return true;
+	}
+
+	void VertletRewind::Truncate(const uint64_t step)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// frames still queued belong to the dropped future
+		m_epoch.fetch_add(1);
+		m_force_keyframe = true;
+
+		while (!m_segments.empty() && m_segments.back().m_first_step > step)
+		{
+			m_frames -= m_segments.back().Frames();
+			m_bytes -= m_segments.back().Bytes();
+			m_segments.pop_back();
+		}
+
+		if (!m_segments.empty() && m_segments.back().LastStep() > step)
+		{
+			Segment& segment = m_segments.back();
+			const size_t keep = static_cast<size_t>(step - segment.m_first_step);
+
+			m_frames -= segment.m_offsets.size() - keep;
+			m_bytes -= segment.Bytes();
+			segment.m_data.resize(segment.m_offsets[keep]);
+			segment.m_offsets.resize(keep);
+			m_bytes += segment.Bytes();
+		}
+	}
+
+	bool VertletRewind::Range(uint64_t& oldest, uint64_t& newest) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (m_segments.empty())
+		{
+			return false;
+		}
+
+		oldest = m_segments.front().m_first_step;
+		newest = m_segments.back().LastStep();
+		return true;
+	}
+
+	size_t VertletRewind::MemoryBytes() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_bytes;
+	}
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "VertletPhysics.h"
+#include "VertletPrototype.h"
+#include "VertletThreading.h"
+
+namespace VertletPhysics
+{
+	/* Frames of history kept, 10 seconds at the scene's physics rate */
+	const size_t g_rewind_frames = 600;
+	/* Memory cap for the history, oldest segments go first */
+	const size_t g_rewind_max_bytes = 64 * 1024 * 1024;
+	/* Frames between keyframes while the topology stays the same */
+	const uint32_t g_rewind_keyframe_interval = 300;
+	/* Positions are stored in steps of 1 / g_rewind_scale pixels */
+	const float g_rewind_scale = 16.f;
+
+	/**
+	 * \brief Bounded history of body states that can be restored at any recorded step
+	 *
+	 * The history is a ring of segments. Each starts with a keyframe holding exact positions and the topology as a
+	 * prototype, shared with the previous segment when no cut, tear or spawn happened in between. The other frames
+	 * store quantised positions as the residual from a constant velocity prediction, zig-zag and Elias gamma
+	 * coded, so a resting point costs a bit per axis and a smoothly moving one about three. Record only copies positions into a
+	 * pooled buffer, indexing keyframes and coding deltas happens on a worker thread. Fluid particles are not recorded.
+	 */
+	class VertletRewind
+	{
+	public:
+		/**
+		 * \param max_frames Frames kept, whole segments are dropped so up to a keyframe interval more may be kept
+		 * \param max_bytes Memory cap, takes priority over max_frames
+		 */
+		explicit VertletRewind(const size_t max_frames = g_rewind_frames, const size_t max_bytes = g_rewind_max_bytes);
+
+		VertletRewind(const VertletRewind&) = delete;
+		VertletRewind& operator=(const VertletRewind&) = delete;
+
+		~VertletRewind();
+
+		/**
+		 * \brief Queues the bodies' state for the worker, never blocks, the frame is skipped if the worker is behind
+		 * \param bodies Bodies to record
+		 * \param step Step number of this state
+		 * \param topology_changed True if points or sticks were added or removed since the last call
+		 */
+		void Record(const std::vector<VertletBody*>& bodies, const uint64_t step, const bool topology_changed);
+
+		/**
+		 * \brief Recreates the bodies as they were at a recorded step, old velocity is approximated from the previous frame
+		 * \param step Step to restore, a step inside Range that was never recorded snaps to the closest one that was
+		 * \param prefer_earlier Side to snap to, the other side is only used if nothing was recorded on this one
+		 * \param out_bodies Vec the restored bodies are appended to
+		 * \param out_step Receives the step actually restored
+		 * \return False if nothing is recorded, out_bodies is then left untouched
+		 */
+		bool Restore(const uint64_t step, const bool prefer_earlier, std::vector<VertletBody*>& out_bodies, uint64_t& out_step) const;
+
+		/**
+		 * \brief Drops history after a step, used when play resumes from a rewound state
+		 * \param step Last step kept
+		 */
+		void Truncate(const uint64_t step);
+
+		/**
+		 * \brief Oldest and newest recorded steps
+		 * \return False if nothing is recorded yet
+		 */
+		bool Range(uint64_t& oldest, uint64_t& newest) const;
+
+		size_t MemoryBytes() const;
+
+		/* Frames skipped because the worker was behind */
+		size_t DroppedFrames() const { return m_dropped.load(std::memory_order_relaxed); }
+
+	private:
+		/**
+		 * \brief State copied on the simulation thread, handed to the worker
+		 */
+		struct PendingFrame
+		{
+			uint64_t m_step{ 0 };
+			uint64_t m_epoch{ 0 };
+			bool m_keyframe{ false };
+			bool m_has_topology{ false };
+			VertletPrototype::Capture m_capture;
+			std::vector<Real> m_x;
+			std::vector<Real> m_y;
+			/* Keyframes only */
+			std::vector<Real> m_oldx;
+			std::vector<Real> m_oldy;
+		};
+
+		/**
+		 * \brief Keyframe plus the coded frames after it
+		 */
+		struct Segment
+		{
+			std::shared_ptr<const VertletPrototype> m_topology;
+			/* Size of m_topology if this segment created it, 0 if shared */
+			size_t m_topology_bytes{ 0 };
+			uint64_t m_first_step{ 0 };
+			std::vector<Real> m_key_x;
+			std::vector<Real> m_key_y;
+			std::vector<Real> m_key_oldx;
+			std::vector<Real> m_key_oldy;
+			/* Coded frames, frame i + 1 starts at m_offsets[i] */
+			std::vector<uint8_t> m_data;
+			std::vector<uint32_t> m_offsets;
+
+			size_t Frames() const { return 1 + m_offsets.size(); }
+			uint64_t LastStep() const { return m_first_step + m_offsets.size(); }
+			size_t Bytes() const;
+		};
+
+		/* Number of pending frames in flight, Record skips frames beyond this */
+		static constexpr size_t s_pool_size = 4;
+
+		void WorkerLoop();
+
+		/**
+		 * \brief Codes one frame into the history, worker thread only
+		 */
+		void Encode(PendingFrame& frame);
+
+		/**
+		 * \brief Drops the oldest segments until the history fits its limits, m_mutex must be held
+		 */
+		void Evict();
+
+		const size_t m_max_frames;
+		const size_t m_max_bytes;
+
+		/* History, shared between the worker and Restore */
+		mutable std::mutex m_mutex;
+		std::deque<Segment> m_segments;
+		size_t m_frames{ 0 };
+		size_t m_bytes{ 0 };
+
+		/* Pending frame pool, full frames go to the worker and come back empty */
+		std::array<PendingFrame, s_pool_size> m_pool;
+		SpscQueue<PendingFrame*, s_pool_size> m_to_worker;
+		SpscQueue<PendingFrame*, s_pool_size> m_free;
+
+		/* Simulation thread state */
+		uint32_t m_since_keyframe{ 0 };
+		bool m_force_keyframe{ true };
+
+		/* Set by the worker when it can't use a frame, the next Record sends a full keyframe */
+		std::atomic<bool> m_need_keyframe{ false };
+		/* Bumped by Truncate, frames from an older epoch are ignored by the worker */
+		std::atomic<uint64_t> m_epoch{ 0 };
+		std::atomic<size_t> m_dropped{ 0 };
+
+		/* Worker thread state, epoch of the open segment and quantised positions of its last two frames */
+		uint64_t m_coding_epoch{ 0 };
+		bool m_coding{ false };
+		std::vector<int32_t> m_prev_x;
+		std::vector<int32_t> m_prev_y;
+		std::vector<int32_t> m_prev2_x;
+		std::vector<int32_t> m_prev2_y;
+		std::vector<uint8_t> m_code;
+
+		std::mutex m_wake_mutex;
+		std::condition_variable m_wake;
+		std::atomic<bool> m_running{ true };
+		std::thread m_worker;
+	};
+}
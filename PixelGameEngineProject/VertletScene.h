@@ -0,0 +1,339 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <thread>
+#include "olcPixelGameEngine.h"
+#include "VertletParallel.h"
+#include "VertletPhysics.h"
+#include "VertletProfiler.h"
+#include "VertletThreading.h"
+#include "VertletWorld.h"
+
+namespace VertletPhysics
+{
+	/* Physics steps per second, the solver runs on its own thread at this rate */
+	const double g_physics_rate = 60.0;
+	/* Cloth in the sample scene tears when pulled past this multiple of its rest length */
+	const float g_scene_tear_ratio = 3.0f;
+	/* Checker squares across the generated cloth texture */
+	const int32_t g_scene_cloth_checks = 8;
+
+	/* Vertlet sample scene */
+	class VertletScene : public olc::PixelGameEngine
+	{
+	public:
+		VertletScene()
+		{			
+			sAppName = "Vertlet Scene";
+		}
+
+		~VertletScene()
+		{
+			StopPhysics();
+		}
+
+		bool OnUserCreate() override
+		{
+			VertletSettings settings;
+			settings.m_tear_ratio = g_scene_tear_ratio;
+
+			m_world = std::make_unique<VertletWorld>(ScreenWidth(), ScreenHeight(), settings);
+			m_world->EnableRewind();
+			m_world->EnableLod();
+			// lets other processes watch the scene, it runs the same without
+			m_world->EnableExport();
+
+			CreateClothTexture();
+
+			m_running = true;
+			m_physics_thread = std::thread([this]() { PhysicsLoop(); });
+
+			return true;
+		}
+
+		bool OnUserUpdate(float fElapsedTime) override
+		{
+			// Mouse motion since last frame, the world turns the sum up to its next step into a direction
+			const olc::vf2d current_mouse_pos = GetWindowMouse();
+
+			VertletInput input;
+			input.m_mouse_delta = last_mouse_pos - current_mouse_pos;
+			input.m_mouse_pos = current_mouse_pos;
+
+			// store last pos for next update
+			last_mouse_pos = current_mouse_pos;
+
+			// check should cut
+			input.m_cut = GetMouse(0).bHeld;
+
+			// create or destroy objects in scene
+			if (GetKey(olc::Q).bPressed)
+			{
+				input.m_command = VertletCommand::DestroyBodies;
+			}
+			else if (GetKey(olc::R).bPressed)
+			{
+				input.m_command = VertletCommand::SpawnNet;
+			}
+			else if (GetKey(olc::C).bPressed && GetKey(olc::SHIFT).bHeld)
+			{
+				input.m_command = VertletCommand::SpawnChainBatch;
+				input.m_spawn_x = static_cast<float>(rand() % 10);
+			}
+			else if (GetKey(olc::C).bPressed)
+			{
+				input.m_command = VertletCommand::SpawnChain;
+				input.m_spawn_x = static_cast<float>(rand() % 1000);
+			}
+			else if (GetKey(olc::W).bPressed)
+			{
+				input.m_command = VertletCommand::ToggleWind;
+			}
+			else if (GetKey(olc::B).bPressed)
+			{
+				input.m_command = VertletCommand::ToggleRewind;
+			}
+			else if (GetKey(olc::F).bPressed)
+			{
+				input.m_command = VertletCommand::SpawnFluid;
+				input.m_spawn_x = static_cast<float>(rand() % 1000);
+			}
+			else if (GetKey(olc::X).bPressed)
+			{
+				input.m_command = VertletCommand::ToggleSolver;
+			}
+
+			// scrub while rewinding, one recorded step per physics step whatever the frame rate
+			if (GetKey(olc::LEFT).bHeld)
+			{
+				input.m_scrub = -1;
+			}
+			else if (GetKey(olc::RIGHT).bHeld)
+			{
+				input.m_scrub = 1;
+			}
+
+			// cycle cloth between wireframe, CPU filled and GPU filled
+			if (GetKey(olc::M).bPressed)
+			{
+				m_render_options.m_cloth = static_cast<ClothRender>((static_cast<int32_t>(m_render_options.m_cloth) + 1) % 3);
+			}
+
+			// inputs without a command fold into the newest unsent one, commands queue behind it in order
+			if (!m_unsent.empty() && m_unsent.back().m_command == VertletCommand::Idle)
+			{
+				m_unsent.back().Merge(input);
+			}
+			else
+			{
+				m_unsent.push_back(input);
+			}
+
+			// physics thread picks these up before its next step, whatever doesn't fit waits for a later frame
+			while (!m_unsent.empty() && m_input.Push(m_unsent.front()))
+			{
+				m_unsent.pop_front();
+			}
+
+#ifdef VERTLET_PROFILING
+			// toggle profiler overlay, dump history
+			if (GetKey(olc::P).bPressed)
+			{
+				m_show_profile = !m_show_profile;
+			}
+
+			if (GetKey(olc::O).bPressed)
+			{
+				VertletProfiler::Get().WriteCsv("vertlet_profile.csv");
+				VertletProfiler::GetRender().WriteCsv("vertlet_render_profile.csv");
+			}
+#endif
+
+			// Render the newest finished physics step
+			m_snapshots.Update();
+
+			Clear(olc::VERY_DARK_CYAN);
+
+			RenderSnapshot(this, m_snapshots.Front(), m_render_options);
+
+			VERTLET_PROFILE_END_RENDER_FRAME();
+
+#ifdef VERTLET_PROFILING
+			if (m_show_profile)
+			{
+				DrawProfileHud();
+			}
+#endif
+
+			return true;
+		}
+
+		bool OnUserDestroy() override
+		{
+			StopPhysics();
+
+			// the texture belongs to the renderer, free it while it still exists
+			m_render_options.m_cloth_decal = nullptr;
+			m_cloth_decal.reset();
+
+			return true;
+		}
+
+	private:
+
+		std::unique_ptr<VertletWorld> m_world;
+
+		/* Engine thread to physics thread */
+		SpscQueue<VertletInput, 256> m_input;
+		/* Inputs the queue had no room for yet, engine thread only */
+		std::deque<VertletInput> m_unsent;
+		/* Physics thread to engine thread */
+		TripleBuffer<VertletSnapshot> m_snapshots;
+
+		/* Draws large snapshots in screen bands, engine thread only */
+		ParallelPool m_render_pool;
+
+		VertletRenderOptions m_render_options;
+		std::unique_ptr<olc::Sprite> m_cloth_sprite;
+		std::unique_ptr<olc::Decal> m_cloth_decal;
+
+		std::thread m_physics_thread;
+		std::atomic<bool> m_running{ false };
+
+		olc::vi2d last_mouse_pos{ 0, 0 };
+
+		/**
+		 * \brief Steps the world at a fixed rate on the physics thread and publishes a snapshot after every step
+		 */
+		void PhysicsLoop()
+		{
+			const auto step_time = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / g_physics_rate));
+			auto next_step = std::chrono::steady_clock::now();
+
+			while (m_running.load(std::memory_order_relaxed))
+			{
+				VertletInput input;
+				while (m_input.Pop(input))
+				{
+					m_world->ApplyInput(input);
+				}
+
+				m_world->Step();
+
+				m_world->WriteSnapshot(m_snapshots.Back());
+				m_snapshots.Publish();
+
+				VERTLET_PROFILE_END_FRAME();
+
+				next_step += step_time;
+
+				// fell behind, don't try to catch up with a burst of steps
+				const auto now = std::chrono::steady_clock::now();
+				if (next_step < now)
+				{
+					next_step = now;
+				}
+
+				std::this_thread::sleep_until(next_step);
+			}
+		}
+
+		/**
+		 * \brief Generates a checker texture for filled cloth and its decal copy
+		 */
+		void CreateClothTexture()
+		{
+			const int32_t size = 128;
+			const int32_t check = size / g_scene_cloth_checks;
+
+			m_cloth_sprite = std::make_unique<olc::Sprite>(size, size);
+
+			for (int32_t y = 0; y < size; y++)
+			{
+				for (int32_t x = 0; x < size; x++)
+				{
+					const bool odd = ((x / check) + (y / check)) % 2 == 1;
+					m_cloth_sprite->SetPixel(x, y, odd ? olc::Pixel(200, 60, 60) : olc::Pixel(230, 210, 170));
+				}
+			}
+
+			m_cloth_decal = std::make_unique<olc::Decal>(m_cloth_sprite.get());
+
+			m_render_options.m_cloth_sprite = m_cloth_sprite.get();
+			m_render_options.m_cloth_decal = m_cloth_decal.get();
+			m_render_options.m_pool = &m_render_pool;
+		}
+
+		void StopPhysics()
+		{
+			m_running = false;
+
+			if (m_physics_thread.joinable())
+			{
+				m_physics_thread.join();
+			}
+		}
+
+#ifdef VERTLET_PROFILING
+		bool m_show_profile{ false };
+
+		/**
+		 * \brief Draws phase times averaged over recent frames and the last frame's counters
+		 */
+		void DrawProfileHud()
+		{
+			const size_t average_frames = 60;
+			ProfileFrame history[average_frames];
+			const size_t count = VertletProfiler::Get().GetHistory(history, average_frames);
+			// render is timed per engine frame, not per physics step
+			ProfileFrame render_history[average_frames];
+			const size_t render_count = VertletProfiler::GetRender().GetHistory(render_history, average_frames);
+
+			if (count == 0)
+			{
+				return;
+			}
+
+			const char* phase_names[] = { "integrate", "sticks", "bounds", "cut", "render", "forces", "fluid" };
+			int32_t y = 10;
+			char line[128];
+
+			for (size_t phase = 0; phase < static_cast<size_t>(ProfilePhase::Count); phase++)
+			{
+				const bool render = phase == static_cast<size_t>(ProfilePhase::Render);
+				const ProfileFrame* frames = render ? render_history : history;
+				const size_t frame_count = render ? render_count : count;
+
+				uint64_t total_ns = 0;
+				for (size_t i = 0; i < frame_count; i++)
+				{
+					total_ns += frames[i].m_phase_ns[phase];
+				}
+
+				snprintf(line, sizeof(line), "%-10s %7.3f ms", phase_names[phase], frame_count > 0 ? total_ns / 1.0e6 / frame_count : 0.0);
+				DrawString(10, y, line, olc::YELLOW);
+				y += 10;
+			}
+
+			const VertletSnapshot& snapshot = m_snapshots.Front();
+			snprintf(line, sizeof(line), "quality %d step %.3f ms", snapshot.m_quality_level, snapshot.m_step_ms);
+			DrawString(10, y, line, olc::YELLOW);
+			y += 10;
+
+			const ProfileFrame& last = history[0];
+			snprintf(line, sizeof(line), "points %llu sticks %llu cuts %llu allocs %llu tears %llu lod skips %llu",
+				static_cast<unsigned long long>(last.Count(ProfileCounter::Points)),
+				static_cast<unsigned long long>(last.Count(ProfileCounter::Sticks)),
+				static_cast<unsigned long long>(last.Count(ProfileCounter::Cuts)),
+				static_cast<unsigned long long>(last.Count(ProfileCounter::Allocations)),
+				static_cast<unsigned long long>(last.Count(ProfileCounter::Tears)),
+				static_cast<unsigned long long>(last.Count(ProfileCounter::LodSkips)));
+			DrawString(10, y, line, olc::YELLOW);
+		}
+#endif
+	};
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "VertletPhysics.h"
+
+namespace VertletPhysics
+{
+	ShapeMatchBody::ShapeMatchBody(std::vector<VertletPoint*>& points, std::vector<VertletStick*>& sticks, const Real stiffness, const bool _draw_points) :
+		VertletBody(points, sticks, _draw_points),
+		m_stiffness(stiffness)
+	{
+		CaptureRestShape();
+	}
+
+	ShapeMatchBody::ShapeMatchBody(std::vector<VertletPoint*>& points, std::vector<VertletStick*>& sticks, const Real stiffness, const bool _draw_points, const std::vector<Real>& rest_x, const std::vector<Real>& rest_y) :
+		VertletBody(points, sticks, _draw_points),
+		m_stiffness(stiffness)
+	{
+		if (rest_x.size() != m_points.size() || rest_y.size() != m_points.size())
+		{
+			CaptureRestShape();
+			return;
+		}
+
+		m_rest_x = rest_x;
+		m_rest_y = rest_y;
+		m_shape_points = m_points;
+	}
+
+	VertletBody::Factory ShapeMatchBody::CopyFactory() const
+	{
+		const Real stiffness = m_stiffness;
+		const bool body_draw_points = draw_points;
+		// a cut since the last pass leaves the rest shape out of step with m_points, copies then take their own
+		const bool shape_current = m_shape_points == m_points;
+		const std::vector<Real> rest_x = shape_current ? m_rest_x : std::vector<Real>();
+		const std::vector<Real> rest_y = shape_current ? m_rest_y : std::vector<Real>();
+
+		return [stiffness, body_draw_points, rest_x, rest_y](std::vector<VertletPoint*>& points, std::vector<VertletStick*>& sticks, const std::vector<uint32_t>&) -> VertletBody*
+		{
+			return new ShapeMatchBody(points, sticks, stiffness, body_draw_points, rest_x, rest_y);
+		};
+	}
+
+	void ShapeMatchBody::CaptureRestShape()
+	{
+		const size_t count = m_points.size();
+
+		m_shape_points = m_points;
+		m_rest_x.resize(count);
+		m_rest_y.resize(count);
+
+		if (count == 0)
+		{
+			return;
+		}
+
+		const Real inv_count = Real(1) / static_cast<int>(count);
+		Real centre_x = 0;
+		Real centre_y = 0;
+
+		for (const auto* p : m_points)
+		{
+			centre_x += p->m_x * inv_count;
+			centre_y += p->m_y * inv_count;
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			m_rest_x[i] = m_points[i]->m_x - centre_x;
+			m_rest_y[i] = m_points[i]->m_y - centre_y;
+		}
+	}
+
+	size_t ShapeMatchBody::SolveConstraints(const VertletSettings&)
+	{
+		VERTLET_PROFILE_SCOPE(Sticks);
+
+		if (m_shape_points != m_points)
+		{
+			CaptureRestShape();
+		}
+
+		const size_t count = m_points.size();
+
+		if (count < 2)
+		{
+			return 0;
+		}
+
+		const Real inv_count = Real(1) / static_cast<int>(count);
+		Real centre_x = 0;
+		Real centre_y = 0;
+
+		for (const auto* p : m_points)
+		{
+			centre_x += p->m_x * inv_count;
+			centre_y += p->m_y * inv_count;
+		}
+
+		// A = sum (p - c) q^T, for a 2x2 the rotation part of A's polar decomposition is
+		// [a -b; b a] / |(a, b)| with a = A00 + A11 and b = A10 - A01, no trig or eigen solve needed
+		Real a = 0;
+		Real b = 0;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const Real px = m_points[i]->m_x - centre_x;
+			const Real py = m_points[i]->m_y - centre_y;
+
+			// averaged rather than summed so fixed point stays in range
+			a += (px * m_rest_x[i] + py * m_rest_y[i]) * inv_count;
+			b += (py * m_rest_x[i] - px * m_rest_y[i]) * inv_count;
+		}
+
+		const Real length = Length(a, b);
+
+		// degenerate, every point on the centre
+		if (length == Real(0))
+		{
+			return 0;
+		}
+
+		const Real cos_r = a / length;
+		const Real sin_r = b / length;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			VertletPoint* p = m_points[i];
+
+			if (p->m_pinned)
+			{
+				continue;
+			}
+
+			const Real goal_x = centre_x + cos_r * m_rest_x[i] - sin_r * m_rest_y[i];
+			const Real goal_y = centre_y + sin_r * m_rest_x[i] + cos_r * m_rest_y[i];
+
+			p->m_x += (goal_x - p->m_x) * m_stiffness;
+			p->m_y += (goal_y - p->m_y) * m_stiffness;
+		}
+
+		return 0;
+	}
+}
@@ -0,0 +1,84 @@
+#include "VertletSweep.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+namespace VertletPhysics
+{
+	std::vector<SweepResult> RunSweep(const std::vector<VertletSettings>& configs, const SweepScene& scene, const int32_t screen_width, const int32_t screen_height, const int32_t frames, int32_t threads)
+	{
+		std::vector<SweepResult> results(configs.size());
+		std::atomic<size_t> next{ 0 };
+
+		if (threads <= 0)
+		{
+			threads = std::max(1, static_cast<int32_t>(std::thread::hardware_concurrency()));
+		}
+		threads = std::min(threads, static_cast<int32_t>(std::max<size_t>(1, configs.size())));
+
+		// each worker pulls the next unclaimed configuration, worlds share nothing so no other sync is needed
+		auto worker = [&]()
+		{
+			for (size_t index = next.fetch_add(1); index < configs.size(); index = next.fetch_add(1))
+			{
+				// fixed parameters, the quality controller would make results depend on machine load
+				VertletWorld world(screen_width, screen_height, configs[index], false);
+				scene(world);
+
+				SweepResult& result = results[index];
+				result.m_settings = configs[index];
+
+				double total_ms = 0;
+
+				for (int32_t frame = 0; frame < frames; frame++)
+				{
+					world.Step();
+					total_ms += world.LastStepMs();
+					result.m_max_step_ms = std::max(result.m_max_step_ms, world.LastStepMs());
+				}
+
+				result.m_frames = frames;
+				result.m_mean_step_ms = frames > 0 ? total_ms / frames : 0;
+				result.m_metrics = world.Measure();
+			}
+		};
+
+		std::vector<std::thread> pool;
+		for (int32_t t = 1; t < threads; t++)
+		{
+			pool.emplace_back(worker);
+		}
+		worker();
+		for (auto& thread : pool)
+		{
+			thread.join();
+		}
+
+		return results;
+	}
+
+	bool WriteSweepCsv(const std::string& path, const std::vector<SweepResult>& results)
+	{
+		std::ofstream file(path);
+
+		if (!file)
+		{
+			return false;
+		}
+
+		file << "bounce,gravity,friction,constrain_loops,substeps,tear_ratio,frames,points,sticks,kinetic_energy,potential_energy,max_stretch,mean_step_ms,max_step_ms\n";
+
+		for (const SweepResult& r : results)
+		{
+			file << ToFloat(r.m_settings.m_bounce) << ',' << ToFloat(r.m_settings.m_gravity) << ',' << ToFloat(r.m_settings.m_friction) << ','
+				<< r.m_settings.m_constrain_loops << ',' << r.m_settings.m_substeps << ',' << ToFloat(r.m_settings.m_tear_ratio) << ',' << r.m_frames << ','
+				<< r.m_metrics.m_points << ',' << r.m_metrics.m_sticks << ','
+				<< r.m_metrics.m_kinetic_energy << ',' << r.m_metrics.m_potential_energy << ',' << r.m_metrics.m_max_stretch << ','
+				<< r.m_mean_step_ms << ',' << r.m_max_step_ms << '\n';
+		}
+
+		return true;
+	}
+}
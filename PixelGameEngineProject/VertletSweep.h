@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "VertletPhysics.h"
+#include "VertletWorld.h"
+
+namespace VertletPhysics
+{
+	/**
+	 * \brief Summary of one sweep configuration after its last frame
+	 */
+	struct SweepResult
+	{
+		VertletSettings m_settings;
+		VertletMetrics m_metrics;
+		int32_t m_frames{ 0 };
+		double m_mean_step_ms{ 0 };
+		double m_max_step_ms{ 0 };
+	};
+
+	/* Fills a fresh world with bodies, called once per configuration from a worker thread */
+	using SweepScene = std::function<void(VertletWorld& world)>;
+
+	/**
+	 * \brief Steps one independent world per configuration, spread over worker threads
+	 * \param configs Settings for each world
+	 * \param scene Scene builder, must only touch the world it is given
+	 * \param screen_width Width of every world
+	 * \param screen_height Height of every world
+	 * \param frames Steps per world
+	 * \param threads Number of worker threads, 0 uses one per hardware thread
+	 * \return One result per configuration, in the same order as configs
+	 */
+	std::vector<SweepResult> RunSweep(const std::vector<VertletSettings>& configs, const SweepScene& scene, const int32_t screen_width, const int32_t screen_height, const int32_t frames, int32_t threads = 0);
+
+	/**
+	 * \brief Writes sweep results as CSV, one row per configuration
+	 * \param path File to write
+	 * \param results Results from RunSweep
+	 * \return True if the file was written
+	 */
+	bool WriteSweepCsv(const std::string& path, const std::vector<SweepResult>& results);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace VertletPhysics
+{
+	/**
+	 * \brief Lock-free triple buffer, one writer publishes whole values and one reader always sees the newest complete one
+	 * \tparam T Value type, slots are reused so vectors inside keep their capacity
+	 */
+	template <typename T>
+	class TripleBuffer
+	{
+	public:
+		/**
+		 * \brief Slot the writer fills, never seen by the reader until Publish
+		 */
+		T& Back() { return m_slots[m_back]; }
+
+		/**
+		 * \brief Hands the back slot to the reader and takes the spare slot as the new back
+		 */
+		void Publish()
+		{
+			const uint8_t previous = m_middle.exchange(static_cast<uint8_t>(m_back | s_fresh), std::memory_order_acq_rel);
+			m_back = previous & s_index_mask;
+		}
+
+		/**
+		 * \brief Swaps in the newest published slot if there is one
+		 * \return True if Front changed
+		 */
+		bool Update()
+		{
+			if ((m_middle.load(std::memory_order_relaxed) & s_fresh) == 0)
+			{
+				return false;
+			}
+
+			const uint8_t previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+			m_front = previous & s_index_mask;
+			return true;
+		}
+
+		/**
+		 * \brief Newest slot taken by Update, stays valid until the next Update
+		 */
+		const T& Front() const { return m_slots[m_front]; }
+
+	private:
+		static constexpr uint8_t s_fresh = 0x4;
+		static constexpr uint8_t s_index_mask = 0x3;
+
+		std::array<T, 3> m_slots{};
+		/* Spare slot index plus fresh flag, the only state shared between threads */
+		std::atomic<uint8_t> m_middle{ 1 };
+		/* Writer owned */
+		uint8_t m_back{ 0 };
+		/* Reader owned */
+		uint8_t m_front{ 2 };
+	};
+
+	/**
+	 * \brief Bounded lock-free single producer, single consumer queue
+	 * \tparam T Value type
+	 * \tparam Capacity Number of slots, must be a power of two
+	 */
+	template <typename T, size_t Capacity>
+	class SpscQueue
+	{
+		static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+	public:
+		/**
+		 * \brief Producer side
+		 * \param value Value to copy in
+		 * \return False if the queue is full
+		 */
+		bool Push(const T& value)
+		{
+			const size_t head = m_head.load(std::memory_order_relaxed);
+
+			if (head - m_tail.load(std::memory_order_acquire) == Capacity)
+			{
+				return false;
+			}
+
+			m_slots[head & (Capacity - 1)] = value;
+			m_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		 * \brief Consumer side
+		 * \param out Receives the oldest value
+		 * \return False if the queue is empty
+		 */
+		bool Pop(T& out)
+		{
+			const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+			if (tail == m_head.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+
+			out = m_slots[tail & (Capacity - 1)];
+			m_tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+	private:
+		std::array<T, Capacity> m_slots{};
+		/* Separate cache lines so producer and consumer don't false share */
+		alignas(64) std::atomic<size_t> m_head{ 0 };
+		alignas(64) std::atomic<size_t> m_tail{ 0 };
+	};
+}
@@ -0,0 +1,577 @@
+#include "VertletWorld.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+namespace VertletPhysics
+{
+	VertletWorld::VertletWorld(const int32_t screen_width, const int32_t screen_height, const VertletSettings& settings, const bool adaptive_quality) :
+		m_screen_width(screen_width),
+		m_screen_height(screen_height),
+		m_settings(settings),
+		m_adaptive_quality(adaptive_quality),
+		m_quality(g_step_budget_ms),
+		m_view_max(static_cast<float>(screen_width), static_cast<float>(screen_height))
+	{
+		// build the chain once, later chains are stamped from the prototype
+		std::vector<VertletBody*> chain;
+		CreateChain(0, 0, chain);
+		m_chain_prototype = VertletPrototype(chain);
+
+		for (auto* body : chain)
+		{
+			delete body;
+		}
+	}
+
+	VertletWorld::~VertletWorld()
+	{
+		DestroyBodies();
+	}
+
+	void VertletWorld::ApplyInput(const VertletInput& input)
+	{
+		m_mouse_delta += input.m_mouse_delta;
+		m_mouse_pos = input.m_mouse_pos;
+		m_cut = m_cut || input.m_cut;
+		m_cut_held = input.m_cut;
+		m_scrub = input.m_scrub;
+
+		if (m_rewind && input.m_command == VertletCommand::ToggleRewind)
+		{
+			uint64_t oldest, newest;
+
+			if (m_rewinding)
+			{
+				// resume from the shown step, the frames after it are a future that no longer happens
+				m_rewind->Truncate(m_step);
+				m_rewinding = false;
+			}
+			else if (m_rewind->Range(oldest, newest))
+			{
+				m_rewinding = true;
+				RewindTo(newest);
+			}
+			return;
+		}
+
+		// the scene is frozen while rewinding, only scrubbing is allowed
+		if (m_rewinding)
+		{
+			return;
+		}
+
+		switch (input.m_command)
+		{
+		case VertletCommand::DestroyBodies:
+			// nets requested before the clear belong to the scene being cleared
+			m_builder.Discard();
+			DestroyBodies();
+			m_fluid.Clear();
+			m_batch.Clear();
+			m_bodies_changed = true;
+			m_lod_groups_dirty = true;
+			break;
+		case VertletCommand::SpawnNet:
+			// built on a worker thread, appears in a later step once ready
+			m_builder.Build([](std::vector<VertletBody*>& out_bodies)
+			{
+				return CreateNet(out_bodies, 10, 10, 250, 80, 5);
+			});
+			break;
+		case VertletCommand::SpawnChain:
+			m_chain_prototype.Instantiate(m_bodies, Real(input.m_spawn_x), 10);
+			m_bodies_changed = true;
+			m_lod_groups_dirty = true;
+			break;
+		case VertletCommand::SpawnChainBatch:
+		{
+			std::vector<VertletBody*> chain;
+
+			for (int32_t i = 0; i < g_batch_spawn_chains; i++)
+			{
+				m_chain_prototype.Instantiate(chain, Real(input.m_spawn_x) + Real(i * m_screen_width / g_batch_spawn_chains), 10);
+				m_batch.Add(chain);
+			}
+			break;
+		}
+		case VertletCommand::ToggleWind:
+			if (m_force_fields.Winds().empty())
+			{
+				m_force_fields.AddWind(1, 0, 0.05f, 0.8f);
+			}
+			else
+			{
+				m_force_fields.Winds().clear();
+			}
+			break;
+		case VertletCommand::SpawnFluid:
+			m_fluid.AddBlock(Real(input.m_spawn_x), 10, 100, 50, 4);
+			break;
+		case VertletCommand::ToggleSolver:
+			m_settings.m_solver = m_settings.m_solver == VertletSolver::Pbd ? VertletSolver::Xpbd : VertletSolver::Pbd;
+			break;
+		case VertletCommand::ToggleRewind:
+		case VertletCommand::Idle:
+			break;
+		}
+	}
+
+	void VertletWorld::Step()
+	{
+		// the motion of every input since the last step, one direction however many frames the engine ran
+		olc::vf2d mouse_dir{ 0, 0 };
+
+		if (m_mouse_delta.x != 0 || m_mouse_delta.y != 0)
+		{
+			mouse_dir = m_mouse_delta.norm();
+		}
+
+		const bool cut = m_cut;
+
+		m_mouse_delta = { 0, 0 };
+		m_cut = m_cut_held;
+
+		if (m_rewinding)
+		{
+			// one recorded step per step while held, RewindTo clamps to the recorded range
+			if (m_scrub < 0 && m_rewind_target > 0)
+			{
+				m_rewind_target--;
+			}
+			else if (m_scrub > 0)
+			{
+				m_rewind_target++;
+			}
+
+			if (m_rewind_target != m_step)
+			{
+				RewindTo(m_rewind_target);
+
+				// restored bodies are new objects, m_bodies_changed stays set for the first recording after resuming
+				if (m_export)
+				{
+					m_export->Publish(m_bodies, m_step, true);
+				}
+			}
+			return;
+		}
+
+		// add any bodies finished since last step
+		if (m_builder.Publish(m_bodies) > 0)
+		{
+			m_bodies_changed = true;
+			m_lod_groups_dirty = true;
+		}
+
+		VertletSettings settings = m_settings;
+
+		if (!m_force_fields.Empty())
+		{
+			settings.m_force_fields = &m_force_fields;
+			m_force_fields.Advance(1);
+		}
+
+		if (m_adaptive_quality)
+		{
+			settings.m_constrain_loops = m_quality.Quality().m_constrain_loops;
+			settings.m_substeps = m_quality.Quality().m_substeps;
+
+			// XPBD spends the same number of stick passes as substeps of one pass each
+			if (settings.m_solver == VertletSolver::Xpbd)
+			{
+				settings.m_substeps *= settings.m_constrain_loops;
+			}
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+
+		if (m_lod_enabled)
+		{
+			ScheduleLod();
+		}
+
+		for (size_t b = 0; b < m_bodies.size(); b++)
+		{
+			const int32_t frames = m_lod_enabled ? m_lod_group_frames[m_lod_group[b]] : 1;
+
+			if (frames == 0)
+			{
+				VERTLET_PROFILE_COUNT(LodSkips, 1);
+				continue;
+			}
+
+			m_bodies[b]->Update(m_screen_width, m_screen_height, mouse_dir, m_mouse_pos, cut, settings, frames);
+		}
+
+		m_batch.Update(m_screen_width, m_screen_height, mouse_dir, m_mouse_pos, cut, settings);
+
+		m_fluid.Update(m_screen_width, m_screen_height, settings, m_bodies);
+
+		m_last_step_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		// adjust for the next step
+		if (m_adaptive_quality)
+		{
+			m_quality.Update(m_last_step_ms);
+		}
+
+		m_step++;
+
+		if (m_rewind || m_export)
+		{
+			const bool topology_changed = TopologyChanged();
+
+			if (m_rewind)
+			{
+				m_rewind->Record(m_bodies, m_step, topology_changed);
+			}
+
+			if (m_export)
+			{
+				m_export->Publish(m_bodies, m_step, topology_changed);
+			}
+		}
+	}
+
+	void VertletWorld::EnableRewind()
+	{
+		if (!m_rewind)
+		{
+			m_rewind = std::make_unique<VertletRewind>();
+			m_bodies_changed = true;
+		}
+	}
+
+	bool VertletWorld::EnableExport(const std::string& name)
+	{
+		if (m_export)
+		{
+			return true;
+		}
+
+		auto shared_export = std::make_unique<VertletSharedExport>();
+
+		if (!shared_export->Open(name))
+		{
+			return false;
+		}
+
+		m_export = std::move(shared_export);
+		m_bodies_changed = true;
+		return true;
+	}
+
+	void VertletWorld::RewindTo(uint64_t step)
+	{
+		uint64_t oldest, newest;
+
+		if (!m_rewind->Range(oldest, newest))
+		{
+			return;
+		}
+
+		step = std::min(std::max(step, oldest), newest);
+
+		// the scene is only replaced once the restore worked, a failed one must not leave the world empty
+		std::vector<VertletBody*> restored;
+		uint64_t restored_step;
+
+		if (!m_rewind->Restore(step, step < m_step, restored, restored_step))
+		{
+			m_rewind_target = m_step;
+			return;
+		}
+
+		// builds started after the restored step never happened there
+		m_builder.Discard();
+		DestroyBodies();
+		m_bodies.swap(restored);
+		m_step = restored_step;
+		m_rewind_target = restored_step;
+		m_bodies_changed = true;
+		m_lod_groups_dirty = true;
+	}
+
+	void VertletWorld::SetView(const float x, const float y, const float width, const float height)
+	{
+		m_view_min = { x, y };
+		m_view_max = { x + width, y + height };
+	}
+
+	uint8_t VertletWorld::LodTier(const VertletBody& body) const
+	{
+		olc::vf2d min, max;
+
+		// never stepped, its bounds are unknown
+		if (!body.Bounds(min, max))
+		{
+			return 0;
+		}
+
+		if (max.x < m_view_min.x || min.x > m_view_max.x || max.y < m_view_min.y || min.y > m_view_max.y)
+		{
+			return g_lod_max_tier;
+		}
+
+		// distance from the cursor to the nearest point of the box
+		const float dx = std::max(std::max(min.x - m_mouse_pos.x, m_mouse_pos.x - max.x), 0.f);
+		const float dy = std::max(std::max(min.y - m_mouse_pos.y, m_mouse_pos.y - max.y), 0.f);
+		const float distance = std::sqrt(dx * dx + dy * dy);
+
+		uint8_t tier = 0;
+
+		for (float near = g_lod_near_distance; distance > near && tier < g_lod_max_tier; near *= 2)
+		{
+			tier++;
+		}
+
+		if (body.m_lod.m_background)
+		{
+			tier = std::max(tier, g_lod_background_tier);
+		}
+
+		return tier;
+	}
+
+	void VertletWorld::BuildLodGroups()
+	{
+		m_point_owner.clear();
+		m_lod_group.resize(m_bodies.size());
+
+		for (uint32_t b = 0; b < m_bodies.size(); b++)
+		{
+			m_lod_group[b] = b;
+
+			for (const auto* point : m_bodies[b]->m_points)
+			{
+				m_point_owner.emplace(point, b);
+			}
+		}
+
+		// union find, the smallest index of a group is its root so the root is stable across rebuilds
+		const auto root = [this](uint32_t b)
+		{
+			while (m_lod_group[b] != b)
+			{
+				b = m_lod_group[b] = m_lod_group[m_lod_group[b]];
+			}
+
+			return b;
+		};
+
+		for (uint32_t b = 0; b < m_bodies.size(); b++)
+		{
+			for (const auto* stick : m_bodies[b]->m_sticks)
+			{
+				for (const VertletPoint* point : { stick->m_pa, stick->m_pb })
+				{
+					const auto owner = m_point_owner.find(point);
+
+					if (owner == m_point_owner.end() || owner->second == b)
+					{
+						continue;
+					}
+
+					const uint32_t ra = root(b);
+					const uint32_t rb = root(owner->second);
+
+					m_lod_group[std::max(ra, rb)] = std::min(ra, rb);
+				}
+			}
+		}
+
+		for (uint32_t b = 0; b < m_bodies.size(); b++)
+		{
+			m_lod_group[b] = root(b);
+		}
+	}
+
+	void VertletWorld::ScheduleLod()
+	{
+		// a cut or tear can split a group
+		uint64_t revisions = 0;
+
+		for (const auto* body : m_bodies)
+		{
+			revisions += body->Revision();
+		}
+
+		if (m_lod_groups_dirty || revisions != m_lod_revisions || m_lod_group.size() != m_bodies.size())
+		{
+			BuildLodGroups();
+			m_lod_groups_dirty = false;
+			m_lod_revisions = revisions;
+		}
+
+		// a group steps at its finest member's tier
+		m_lod_group_frames.assign(m_bodies.size(), 0);
+		m_lod_group_tiers.assign(m_bodies.size(), g_lod_max_tier);
+
+		for (uint32_t b = 0; b < m_bodies.size(); b++)
+		{
+			VertletLod& lod = m_bodies[b]->m_lod;
+
+			if (!lod.m_has_slot)
+			{
+				lod.m_slot = m_next_lod_slot++ & ((1 << g_lod_max_tier) - 1);
+				lod.m_has_slot = true;
+			}
+
+			uint8_t& tier = m_lod_group_tiers[m_lod_group[b]];
+			tier = std::min(tier, LodTier(*m_bodies[b]));
+		}
+
+		for (uint32_t b = 0; b < m_bodies.size(); b++)
+		{
+			if (m_lod_group[b] != b)
+			{
+				continue;
+			}
+
+			VertletLod& lod = m_bodies[b]->m_lod;
+			lod.m_tier = m_lod_group_tiers[b];
+
+			// step on the group's slot of its tier's period, a group that just dropped tier waits at most the old period
+			const uint64_t period = uint64_t(1) << lod.m_tier;
+			const bool slot_due = ((m_step + lod.m_slot) & (period - 1)) == 0;
+			const bool waited = lod.m_pending + 1u >= period;
+
+			if (!(slot_due && waited) && lod.m_pending + 1u < (1u << g_lod_max_tier))
+			{
+				lod.m_pending++;
+				continue;
+			}
+
+			m_lod_group_frames[b] = lod.m_pending + 1;
+			lod.m_pending = 0;
+		}
+
+		// members mirror their root so a body leaving the group on a cut carries on from the same schedule
+		for (uint32_t b = 0; b < m_bodies.size(); b++)
+		{
+			const VertletLod& root = m_bodies[m_lod_group[b]]->m_lod;
+			VertletLod& lod = m_bodies[b]->m_lod;
+			lod.m_slot = root.m_slot;
+			lod.m_tier = root.m_tier;
+			lod.m_pending = root.m_pending;
+		}
+	}
+
+	bool VertletWorld::TopologyChanged()
+	{
+		uint64_t revisions = 0;
+
+		for (const auto* body : m_bodies)
+		{
+			revisions += body->Revision();
+		}
+
+		// revisions only grow while the body set is unchanged, so a different sum means a cut or tear
+		const bool changed = m_bodies_changed || revisions != m_revisions;
+
+		m_bodies_changed = false;
+		m_revisions = revisions;
+		return changed;
+	}
+
+	void VertletWorld::WriteSnapshot(VertletSnapshot& out) const
+	{
+		out.Clear();
+		out.m_step = m_step;
+		out.m_quality_level = m_quality.Level();
+		out.m_step_ms = m_last_step_ms;
+
+		const bool draw_points = !m_adaptive_quality || m_quality.Quality().m_draw_points;
+
+		for (const auto& body : m_bodies)
+		{
+			body->WriteSnapshot(out, draw_points);
+		}
+
+		m_batch.WriteSnapshot(out, draw_points);
+
+		m_fluid.WriteSnapshot(out);
+	}
+
+	void VertletWorld::DestroyBodies()
+	{
+		for (auto&& body : m_bodies)
+		{
+			delete body;
+		}
+
+		m_bodies.clear();
+	}
+
+	void VertletWorld::AddBodies(const std::vector<VertletBody*>& bodies)
+	{
+		m_bodies.insert(m_bodies.end(), bodies.begin(), bodies.end());
+		m_bodies_changed = true;
+		m_lod_groups_dirty = true;
+	}
+
+	VertletMetrics VertletWorld::Measure() const
+	{
+		VertletMetrics metrics;
+		const double gravity = ToFloat(m_settings.m_gravity);
+
+		for (const auto* body : m_bodies)
+		{
+			metrics.m_points += body->m_points.size();
+			metrics.m_sticks += body->m_sticks.size();
+
+			for (const auto* p : body->m_points)
+			{
+				const double vx = ToFloat(p->m_x - p->m_oldx);
+				const double vy = ToFloat(p->m_y - p->m_oldy);
+
+				metrics.m_kinetic_energy += 0.5 * (vx * vx + vy * vy);
+				metrics.m_potential_energy += gravity * (m_screen_height - ToFloat(p->m_y));
+			}
+
+			for (const auto* s : body->m_sticks)
+			{
+				const double length = ToFloat(Distance(s->m_pa, s->m_pb));
+				const double rest = ToFloat(s->m_length);
+
+				if (rest > 0)
+				{
+					metrics.m_max_stretch = std::max(metrics.m_max_stretch, length / rest - 1.0);
+				}
+			}
+		}
+
+		const auto& x = m_batch.X();
+		const auto& y = m_batch.Y();
+
+		metrics.m_points += m_batch.PointCount();
+		metrics.m_sticks += m_batch.StickCount();
+
+		for (size_t i = 0; i < x.size(); i++)
+		{
+			const double vx = ToFloat(x[i] - m_batch.OldX()[i]);
+			const double vy = ToFloat(y[i] - m_batch.OldY()[i]);
+
+			metrics.m_kinetic_energy += 0.5 * (vx * vx + vy * vy);
+			metrics.m_potential_energy += gravity * (m_screen_height - ToFloat(y[i]));
+		}
+
+		for (size_t i = 0; i < m_batch.StickCount(); i++)
+		{
+			const uint32_t a = m_batch.StickA()[i];
+			const uint32_t b = m_batch.StickB()[i];
+			const double length = ToFloat(Length(x[b] - x[a], y[b] - y[a]));
+			const double rest = ToFloat(m_batch.StickLength()[i]);
+
+			if (rest > 0)
+			{
+				metrics.m_max_stretch = std::max(metrics.m_max_stretch, length / rest - 1.0);
+			}
+		}
+
+		return metrics;
+	}
+}
\ No newline at end of file
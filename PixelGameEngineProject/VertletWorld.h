@@ -0,0 +1,278 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "VertletBatch.h"
+#include "VertletBuilder.h"
+#include "VertletExport.h"
+#include "VertletFluid.h"
+#include "VertletPhysics.h"
+#include "VertletPrototype.h"
+#include "VertletQuality.h"
+#include "VertletRewind.h"
+
+namespace VertletPhysics
+{
+	/* Solver budget per step, leaves the rest of a 60hz step for snapshots and the scheduler */
+	const double g_step_budget_ms = 10.0;
+	/* Bodies within this many pixels of the cursor step every frame, each doubling of the distance drops a tier */
+	const float g_lod_near_distance = 200.f;
+	/* Tier forced on bodies flagged as background */
+	const uint8_t g_lod_background_tier = 2;
+	/* Chains added to the batch by one SpawnChainBatch */
+	const int32_t g_batch_spawn_chains = 100;
+
+	/* Scene changes requested through VertletInput */
+	enum class VertletCommand : uint8_t
+	{
+		Idle,
+		DestroyBodies,
+		SpawnNet,
+		SpawnChain,
+		/* Many chains across the screen, stepped together in the batch */
+		SpawnChainBatch,
+		ToggleWind,
+		SpawnFluid,
+		/* Pause and enter rewind, or resume from the rewound step, VertletInput::m_scrub moves through the steps */
+		ToggleRewind,
+		/* Switch sticks between the Pbd and Xpbd solvers */
+		ToggleSolver
+	};
+
+	/**
+	 * \brief Input state and commands sent from the engine thread to the physics thread
+	 *
+	 * The engine usually runs several frames per physics step, so the world sums the mouse motion of every input
+	 * between two steps and keeps a cut that was pressed at any point in between.
+	 */
+	struct VertletInput
+	{
+		VertletCommand m_command{ VertletCommand::Idle };
+		/* X position for spawn commands */
+		float m_spawn_x{ 0 };
+		/* Mouse motion since the previous input, previous position minus current */
+		olc::vf2d m_mouse_delta{ 0, 0 };
+		olc::vf2d m_mouse_pos{ 0, 0 };
+		bool m_cut{ false };
+		/* Held rewind direction, -1 back, 1 forward, the world moves one recorded step per step */
+		int8_t m_scrub{ 0 };
+
+		/**
+		 * \brief Folds a newer input into this one, for inputs that could not be sent yet
+		 * \param newer Input from a later frame, takes over the command so this one must not have one
+		 */
+		void Merge(const VertletInput& newer)
+		{
+			m_command = newer.m_command;
+			m_spawn_x = newer.m_spawn_x;
+			m_mouse_delta += newer.m_mouse_delta;
+			m_mouse_pos = newer.m_mouse_pos;
+			m_cut = m_cut || newer.m_cut;
+			m_scrub = newer.m_scrub;
+		}
+	};
+
+	/**
+	 * \brief Summary measurements of a world's current state, unit point mass
+	 */
+	struct VertletMetrics
+	{
+		size_t m_points{ 0 };
+		size_t m_sticks{ 0 };
+		/* Sum of 0.5 * v^2, v in pixels per frame */
+		double m_kinetic_energy{ 0 };
+		/* Sum of gravity * height above the bottom of the screen */
+		double m_potential_energy{ 0 };
+		/* Largest stick length over rest length, minus one */
+		double m_max_stretch{ 0 };
+	};
+
+	/**
+	 * \brief Owns every body in a scene and steps them, touched by one thread at a time
+	 */
+	class VertletWorld
+	{
+	public:
+		/**
+		 * \param screen_width Width of the bounds points are kept in
+		 * \param screen_height Height of the bounds points are kept in
+		 * \param settings Simulation parameters for this world
+		 * \param adaptive_quality True to let the quality controller override constrain loops and substeps
+		 */
+		VertletWorld(const int32_t screen_width, const int32_t screen_height, const VertletSettings& settings = VertletSettings(), const bool adaptive_quality = true);
+
+		VertletWorld(const VertletWorld&) = delete;
+		VertletWorld& operator=(const VertletWorld&) = delete;
+
+		~VertletWorld();
+
+		/**
+		 * \brief Runs the input's command and adds its mouse state to what the next step applies
+		 * \param input Input to apply
+		 */
+		void ApplyInput(const VertletInput& input);
+
+		/**
+		 * \brief Publishes finished async builds, updates every body once at the current quality, then lets the quality controller react to the cost
+		 */
+		void Step();
+
+		/**
+		 * \brief Replaces the snapshot contents with the current state
+		 * \param out Snapshot to fill
+		 */
+		void WriteSnapshot(VertletSnapshot& out) const;
+
+		void DestroyBodies();
+
+		/**
+		 * \brief Takes ownership of bodies created outside the world
+		 * \param bodies Bodies to add
+		 */
+		void AddBodies(const std::vector<VertletBody*>& bodies);
+
+		/**
+		 * \brief Measures energy and stretch over every body
+		 */
+		VertletMetrics Measure() const;
+
+		const VertletSettings& Settings() const { return m_settings; }
+
+		/* Fields applied to every body, only touch from the thread that steps the world */
+		VertletForceFields& ForceFields() { return m_force_fields; }
+
+		/* Fluid particles colliding with every body, only touch from the thread that steps the world */
+		VertletFluid& Fluid() { return m_fluid; }
+
+		/* Small bodies stored and stepped together, only touch from the thread that steps the world */
+		VertletBatch& Batch() { return m_batch; }
+
+		/* Solver time of the most recent Step */
+		double LastStepMs() const { return m_last_step_ms; }
+
+		const std::vector<VertletBody*>& Bodies() const { return m_bodies; }
+
+		const VertletQualityController& QualityController() const { return m_quality; }
+
+		/**
+		 * \brief Starts recording every step so it can be rewound to, off by default as recording runs its own worker thread
+		 */
+		void EnableRewind();
+
+		/* Null unless EnableRewind was called */
+		const VertletRewind* Rewind() const { return m_rewind.get(); }
+
+		bool Rewinding() const { return m_rewinding; }
+
+		/**
+		 * \brief Publishes every step into a named shared memory ring other processes can map, see VertletExport.h
+		 * \param name Shared memory object name
+		 * \return False if the shared memory could not be created, the world runs on without exporting
+		 */
+		bool EnableExport(const std::string& name = g_export_name);
+
+		/**
+		 * \brief Lets bodies outside the view, far from the cursor or flagged as background step at a reduced rate,
+		 * off by default so results don't depend on where the view and cursor are
+		 * \param enabled True to schedule by level of detail, false to step every body every frame
+		 */
+		void EnableLod(const bool enabled = true) { m_lod_enabled = enabled; }
+
+		/**
+		 * \brief Area the player sees, bodies whose bounds miss it drop to the coarsest tier, defaults to the screen
+		 */
+		void SetView(const float x, const float y, const float width, const float height);
+
+		/* Null unless EnableExport succeeded */
+		const VertletSharedExport* Export() const { return m_export.get(); }
+
+	private:
+		/**
+		 * \brief Replaces the bodies with the recorded state of a step
+		 * \param step Step to show, clamped to the recorded range
+		 */
+		void RewindTo(uint64_t step);
+
+		/**
+		 * \brief Tier a body should step at this frame from its last bounds, the view and the cursor
+		 */
+		uint8_t LodTier(const VertletBody& body) const;
+
+		/**
+		 * \brief Groups bodies joined by a stick into a shared point, a group shares one slot and tier so its bodies
+		 * always step together
+		 */
+		void BuildLodGroups();
+
+		/**
+		 * \brief Fills m_lod_group_frames with the frames each group steps this frame, 0 when it skips
+		 */
+		void ScheduleLod();
+
+		/**
+		 * \brief True if a spawn, destroy, cut or tear happened since the last call
+		 */
+		bool TopologyChanged();
+
+		const int32_t m_screen_width;
+		const int32_t m_screen_height;
+
+		VertletSettings m_settings;
+		const bool m_adaptive_quality;
+
+		VertletForceFields m_force_fields;
+
+		VertletFluid m_fluid;
+
+		VertletBatch m_batch;
+
+		std::vector<VertletBody*> m_bodies;
+
+		AsyncBodyBuilder m_builder;
+
+		VertletPrototype m_chain_prototype;
+
+		VertletQualityController m_quality;
+		double m_last_step_ms{ 0 };
+
+		/* Mouse motion summed over the inputs since the last step, normalised and cleared by Step */
+		olc::vf2d m_mouse_delta{ 0, 0 };
+		olc::vf2d m_mouse_pos{ 0, 0 };
+		/* Cut for the next step, latched by a press so a click between two steps still cuts */
+		bool m_cut{ false };
+		/* Whether the newest input still holds the cut, m_cut falls back to it after a step */
+		bool m_cut_held{ false };
+		int8_t m_scrub{ 0 };
+
+		uint64_t m_step{ 0 };
+
+		std::unique_ptr<VertletRewind> m_rewind;
+		bool m_rewinding{ false };
+		uint64_t m_rewind_target{ 0 };
+		/* Set by anything that adds or removes bodies */
+		bool m_bodies_changed{ true };
+		/* Sum of body revisions at the last TopologyChanged */
+		uint64_t m_revisions{ 0 };
+
+		std::unique_ptr<VertletSharedExport> m_export;
+
+		bool m_lod_enabled{ false };
+		olc::vf2d m_view_min{ 0, 0 };
+		olc::vf2d m_view_max{ 0, 0 };
+		/* Next stagger slot handed to a body, spreads each tier's bodies evenly over its period */
+		uint8_t m_next_lod_slot{ 0 };
+		/* Index of the first body of each body's group, its slot and pending decide for the whole group */
+		std::vector<uint32_t> m_lod_group;
+		/* Frames to step per group, indexed by the group's first body */
+		std::vector<int32_t> m_lod_group_frames;
+		std::vector<uint8_t> m_lod_group_tiers;
+		/* Set by anything that adds or removes bodies, cuts and tears are caught by m_lod_revisions */
+		bool m_lod_groups_dirty{ true };
+		uint64_t m_lod_revisions{ 0 };
+		/* Body owning each point, kept to reuse its buckets */
+		std::unordered_map<const VertletPoint*, uint32_t> m_point_owner;
+	};
+}
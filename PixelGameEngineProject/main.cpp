@@ -1,7 +1,7 @@
 #define OLC_PGE_APPLICATION
 #include "olcPixelGameEngine.h"
 //#include "Utility.h"
-#include "VertletPhysics.h"
+#include "VertletScene.h"
 
 int main()
 {
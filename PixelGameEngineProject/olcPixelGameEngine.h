@@ -321,6 +321,17 @@ namespace _gfs = std::experimental::filesystem::v1;
 namespace _gfs = std::filesystem;
 #endif
 
+// Widest vector stores the target supports, used by the pixel fill kernels. Define OLC_NO_SIMD for the scalar path
+#if !defined(OLC_NO_SIMD)
+#if defined(__AVX2__)
+#define OLC_SIMD_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OLC_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#endif
+
 #if defined(UNICODE) || defined(_UNICODE)
 #define olcT(s) L##s
 #else
@@ -439,9 +450,10 @@ namespace olc
 
 		enum Mode { NORMAL, MASK, ALPHA, CUSTOM };
 
-		Pixel();
-		Pixel(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha = nDefaultAlpha);
-		Pixel(uint32_t p);
+		// Constructors are inline so headers using only the colour constants link without the implementation
+		Pixel() { r = 0; g = 0; b = 0; a = nDefaultAlpha; }
+		Pixel(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha = nDefaultAlpha) { n = red | (green << 8) | (blue << 16) | (alpha << 24); } // Thanks jarekpelczar
+		Pixel(uint32_t p) { n = p; }
 		Pixel& operator = (const Pixel& v) = default;
 		bool   operator ==(const Pixel& p) const;
 		bool   operator !=(const Pixel& p) const;
@@ -584,6 +596,17 @@ namespace olc
 
 
 
+	// O------------------------------------------------------------------------------O
+	// | olc::LineSegment - End points of one line in a DrawLines batch               |
+	// O------------------------------------------------------------------------------O
+	struct LineSegment
+	{
+		int32_t x1 = 0; int32_t y1 = 0;
+		int32_t x2 = 0; int32_t y2 = 0;
+	};
+
+
+
 	// O------------------------------------------------------------------------------O
 	// | olc::HWButton - Represents the state of a hardware button (mouse/key/joy)    |
 	// O------------------------------------------------------------------------------O
@@ -674,6 +697,41 @@ namespace olc
 		static std::unique_ptr<olc::ImageLoader> loader;
 	};
 
+	// O------------------------------------------------------------------------------O
+	// | olc::Stamp - A small shape rasterized once as row spans, drawn by DrawStamp  |
+	// O------------------------------------------------------------------------------O
+	class Stamp
+	{
+	public:
+		// One row of covered pixels, x0 to x1 inclusive, relative to the stamp origin
+		struct Span
+		{
+			int32_t y = 0;
+			int32_t x0 = 0;
+			int32_t x1 = 0;
+		};
+
+	public:
+		Stamp() = default;
+		// The pixels FillCircle covers for a circle of this radius around the origin
+		static Stamp Circle(int32_t radius);
+		// The pixels of a sprite with full alpha, origin at the sprite's top left
+		static Stamp FromSprite(const olc::Sprite* sprite);
+
+	public:
+		// Adds a row, rows must be added top to bottom and must not overlap earlier spans
+		void AddSpan(int32_t y, int32_t x0, int32_t x1);
+		const std::vector<Span>& GetSpans() const;
+		bool IsEmpty() const;
+
+	public:
+		// Bounding box of every span, relative to the origin
+		int32_t left = 0, top = 0, right = -1, bottom = -1;
+
+	private:
+		std::vector<Span> vSpans;
+	};
+
 	// O------------------------------------------------------------------------------O
 	// | olc::Decal - A GPU resident storage of an olc::Sprite                        |
 	// O------------------------------------------------------------------------------O
@@ -702,6 +760,13 @@ namespace olc
 		WIREFRAME,
 	};
 
+	// How the vertices of a DecalInstance form triangles
+	enum class DecalStructure
+	{
+		FAN,
+		LIST,
+	};
+
 	// O------------------------------------------------------------------------------O
 	// | olc::Renderable - Convenience class to keep a sprite and decal together      |
 	// O------------------------------------------------------------------------------O
@@ -732,6 +797,7 @@ namespace olc
 		std::vector<float> w;
 		std::vector<olc::Pixel> tint;
 		olc::DecalMode mode = olc::DecalMode::NORMAL;
+		olc::DecalStructure structure = olc::DecalStructure::FAN;
 		uint32_t points = 0;
 	};
 
@@ -888,18 +954,32 @@ namespace olc
 
 
 	public: // DRAWING ROUTINES
-		// Draws a single Pixel
+		// Draws a single Pixel. DrawLine, DrawRect, DrawTriangle, FillRect, FillCircle, FillTriangle, DrawStamp and
+		// the span and batch routines write the draw target directly with the pixel mode resolved per span or per
+		// primitive, so an override of Draw does not see their pixels. DrawCircle, DrawSprite, DrawPartialSprite and
+		// DrawString still plot through Draw
 		virtual bool Draw(int32_t x, int32_t y, Pixel p = olc::WHITE);
 		bool Draw(const olc::vi2d& pos, Pixel p = olc::WHITE);
+		// Fills pixels x0 to x1 inclusive of row y, clipped to the draw target, resolving the pixel mode once for the span
+		void FillSpan(int32_t x0, int32_t x1, int32_t y, Pixel p = olc::WHITE);
+		// As FillSpan, but always alpha blends with the blend factor whatever the pixel mode
+		void BlendSpan(int32_t x0, int32_t x1, int32_t y, Pixel p = olc::WHITE);
 		// Draws a line from (x1,y1) to (x2,y2)
 		void DrawLine(int32_t x1, int32_t y1, int32_t x2, int32_t y2, Pixel p = olc::WHITE, uint32_t pattern = 0xFFFFFFFF);
 		void DrawLine(const olc::vi2d& pos1, const olc::vi2d& pos2, Pixel p = olc::WHITE, uint32_t pattern = 0xFFFFFFFF);
+		// Draws a batch of solid lines with the same pixels DrawLine would, each is clipped to the draw target and
+		// rows [yBegin, yEnd) before it is rasterized and the pixel mode is resolved once for the whole batch.
+		// Calls with disjoint row ranges write disjoint pixels, so a batch can be split into bands across threads
+		void DrawLines(const olc::LineSegment* lines, size_t count, Pixel p = olc::WHITE, int32_t yBegin = 0, int32_t yEnd = INT32_MAX);
 		// Draws a circle located at (x,y) with radius
 		void DrawCircle(int32_t x, int32_t y, int32_t radius, Pixel p = olc::WHITE, uint8_t mask = 0xFF);
 		void DrawCircle(const olc::vi2d& pos, int32_t radius, Pixel p = olc::WHITE, uint8_t mask = 0xFF);
 		// Fills a circle located at (x,y) with radius
 		void FillCircle(int32_t x, int32_t y, int32_t radius, Pixel p = olc::WHITE);
 		void FillCircle(const olc::vi2d& pos, int32_t radius, Pixel p = olc::WHITE);
+		// Draws a pre-rasterized stamp with its origin at (x,y), row by row with the pixel mode resolved once
+		void DrawStamp(int32_t x, int32_t y, const olc::Stamp& stamp, Pixel p = olc::WHITE);
+		void DrawStamp(const olc::vi2d& pos, const olc::Stamp& stamp, Pixel p = olc::WHITE);
 		// Draws a rectangle at (x,y) to (x+w,y+h)
 		void DrawRect(int32_t x, int32_t y, int32_t w, int32_t h, Pixel p = olc::WHITE);
 		void DrawRect(const olc::vi2d& pos, const olc::vi2d& size, Pixel p = olc::WHITE);
@@ -912,6 +992,10 @@ namespace olc
 		// Flat fills a triangle between points (x1,y1), (x2,y2) and (x3,y3)
 		void FillTriangle(int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t x3, int32_t y3, Pixel p = olc::WHITE);
 		void FillTriangle(const olc::vi2d& pos1, const olc::vi2d& pos2, const olc::vi2d& pos3, Pixel p = olc::WHITE);
+		// Fills a batch of triangles, three vertices each, covering pixels whose centres are inside. If sprite is given
+		// it is sampled nearest at the interpolated uv (0 - 1) and multiplied by tint, otherwise tint is the colour.
+		// Clipped to the draw target and rows [yBegin, yEnd) like DrawLines, with the pixel mode resolved once
+		void FillTriangles(const olc::vf2d* pos, const olc::vf2d* uv, size_t vertices, olc::Sprite* sprite = nullptr, Pixel tint = olc::WHITE, int32_t yBegin = 0, int32_t yEnd = INT32_MAX);
 		// Draws an entire sprite at location (x,y)
 		void DrawSprite(int32_t x, int32_t y, Sprite* sprite, uint32_t scale = 1, uint8_t flip = olc::Sprite::NONE);
 		void DrawSprite(const olc::vi2d& pos, Sprite* sprite, uint32_t scale = 1, uint8_t flip = olc::Sprite::NONE);
@@ -949,6 +1033,8 @@ namespace olc
 		void GradientFillRectDecal(const olc::vf2d& pos, const olc::vf2d& size, const olc::Pixel colTL, const olc::Pixel colBL, const olc::Pixel colBR, const olc::Pixel colTR);
 		// Draws an arbitrary convex textured polygon using GPU
 		void DrawPolygonDecal(olc::Decal* decal, const std::vector<olc::vf2d>& pos, const std::vector<olc::vf2d>& uv, const olc::Pixel tint = olc::WHITE);
+		// Draws a list of triangles, three vertices each, as one GPU batch, decal may be nullptr for flat tint
+		void DrawTrianglesDecal(olc::Decal* decal, const olc::vf2d* pos, const olc::vf2d* uv, uint32_t vertices, const olc::Pixel tint = olc::WHITE);
 		// Draws a single line of text - traditional monospaced
 		void DrawString(int32_t x, int32_t y, const std::string& sText, Pixel col = olc::WHITE, uint32_t scale = 1);
 		void DrawString(const olc::vi2d& pos, const std::string& sText, Pixel col = olc::WHITE, uint32_t scale = 1);
@@ -1116,22 +1202,6 @@ namespace olc
 	// O------------------------------------------------------------------------------O
 	// | olc::Pixel IMPLEMENTATION                                                    |
 	// O------------------------------------------------------------------------------O
-	Pixel::Pixel()
-	{
-		r = 0; g = 0; b = 0; a = nDefaultAlpha;
-	}
-
-	Pixel::Pixel(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha)
-	{
-		n = red | (green << 8) | (blue << 16) | (alpha << 24);
-	} // Thanks jarekpelczar 
-
-
-	Pixel::Pixel(uint32_t p)
-	{
-		n = p;
-	}
-
 	bool Pixel::operator==(const Pixel& p) const
 	{
 		return n == p.n;
@@ -1380,6 +1450,85 @@ namespace olc
 		return pColData;
 	}
 
+	// O------------------------------------------------------------------------------O
+	// | olc::Stamp IMPLEMENTATION                                                    |
+	// O------------------------------------------------------------------------------O
+	Stamp Stamp::Circle(int32_t radius)
+	{
+		Stamp stamp;
+		if (radius < 0) return stamp;
+
+		// Widest extent FillCircle draws on each row, it draws some rows more than once
+		std::vector<int32_t> vHalfWidth(2 * size_t(radius) + 1, -1);
+		auto row = [&](int32_t half, int32_t y) { vHalfWidth[y + radius] = std::max(vHalfWidth[y + radius], half); };
+
+		int x0 = 0;
+		int y0 = radius;
+		int d = 3 - 2 * radius;
+
+		while (y0 >= x0)
+		{
+			row(y0, -x0);
+			if (x0 > 0) row(y0, x0);
+
+			if (d < 0)
+				d += 4 * x0++ + 6;
+			else
+			{
+				if (x0 != y0)
+				{
+					row(x0, -y0);
+					row(x0, y0);
+				}
+				d += 4 * (x0++ - y0--) + 10;
+			}
+		}
+
+		for (int32_t y = -radius; y <= radius; y++)
+			if (vHalfWidth[y + radius] >= 0) stamp.AddSpan(y, -vHalfWidth[y + radius], vHalfWidth[y + radius]);
+
+		return stamp;
+	}
+
+	Stamp Stamp::FromSprite(const olc::Sprite* sprite)
+	{
+		Stamp stamp;
+		if (sprite == nullptr) return stamp;
+
+		for (int32_t y = 0; y < sprite->height; y++)
+		{
+			int32_t x = 0;
+			while (x < sprite->width)
+			{
+				while (x < sprite->width && sprite->pColData[y * sprite->width + x].a != 255) x++;
+				int32_t x0 = x;
+				while (x < sprite->width && sprite->pColData[y * sprite->width + x].a == 255) x++;
+				if (x > x0) stamp.AddSpan(y, x0, x - 1);
+			}
+		}
+
+		return stamp;
+	}
+
+	void Stamp::AddSpan(int32_t y, int32_t x0, int32_t x1)
+	{
+		if (x1 < x0) return;
+		if (vSpans.empty()) { left = x0; right = x1; top = bottom = y; }
+		left = std::min(left, x0); right = std::max(right, x1);
+		top = std::min(top, y); bottom = std::max(bottom, y);
+		vSpans.push_back({ y, x0, x1 });
+	}
+
+	const std::vector<Stamp::Span>& Stamp::GetSpans() const
+	{
+		return vSpans;
+	}
+
+	bool Stamp::IsEmpty() const
+	{
+		return vSpans.empty();
+	}
+
 
 	olc::rcode Sprite::LoadFromFile(const std::string& sImageFile, olc::ResourcePack* pack)
 	{
@@ -1951,88 +2100,378 @@ namespace olc
 	}
 
 
-	void PixelGameEngine::DrawLine(const olc::vi2d& pos1, const olc::vi2d& pos2, Pixel p, uint32_t pattern)
+	// Writes count copies of p from dst, whole 32 bit pixels per lane with the widest stores the build allows
+	static inline void FillPixels(Pixel* dst, size_t count, Pixel p)
 	{
-		DrawLine(pos1.x, pos1.y, pos2.x, pos2.y, p, pattern);
+		size_t i = 0;
+#if defined(OLC_SIMD_AVX2)
+		const __m256i v8 = _mm256_set1_epi32(int32_t(p.n));
+		for (; i + 8 <= count; i += 8) _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v8);
+#endif
+#if defined(OLC_SIMD_AVX2) || defined(OLC_SIMD_SSE2)
+		const __m128i v4 = _mm_set1_epi32(int32_t(p.n));
+		for (; i + 4 <= count; i += 4) _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v4);
+#endif
+		for (; i < count; i++) dst[i] = p;
 	}
 
-	void PixelGameEngine::DrawLine(int32_t x1, int32_t y1, int32_t x2, int32_t y2, Pixel p, uint32_t pattern)
+	// Writes pixels x0 to x1 of row y with the pixel mode fixed at compile time, clipped to the w by h target
+	template<Pixel::Mode Mode>
+	static void WriteSpan(Pixel* data, int32_t w, int32_t h, int32_t x0, int32_t x1, int32_t y, Pixel c, float fBlend, const std::function<olc::Pixel(const int x, const int y, const olc::Pixel&, const olc::Pixel&)>& custom)
+	{
+		if (y < 0 || y >= h) return;
+		x0 = std::max(x0, 0); x1 = std::min(x1, w - 1);
+		if (x0 > x1) return;
+
+		Pixel* row = data + y * w;
+
+		if constexpr (Mode == Pixel::NORMAL)
+		{
+			FillPixels(row + x0, size_t(x1 - x0 + 1), c);
+		}
+		else if constexpr (Mode == Pixel::MASK)
+		{
+			if (c.a == 255) FillPixels(row + x0, size_t(x1 - x0 + 1), c);
+		}
+		else if constexpr (Mode == Pixel::ALPHA)
+		{
+			// Source terms are the same across the span, so only the destination terms are per pixel
+			float a = (float)(c.a / 255.0f) * fBlend;
+			float ca = 1.0f - a;
+			float sr = a * (float)c.r, sg = a * (float)c.g, sb = a * (float)c.b;
+			for (int32_t x = x0; x <= x1; x++)
+			{
+				Pixel& d = row[x];
+				d = Pixel((uint8_t)(sr + ca * (float)d.r), (uint8_t)(sg + ca * (float)d.g), (uint8_t)(sb + ca * (float)d.b));
+			}
+		}
+		else
+		{
+			for (int32_t x = x0; x <= x1; x++) row[x] = custom(x, y, c, row[x]);
+		}
+	}
+
+	// Calls draw with a span(x0, x1, y, colour) functor for the pixel mode, so a primitive made of many spans picks
+	// the mode once. Spans are inclusive and clipped to the w by h target
+	template<typename DrawFunc>
+	static void WithPixelModeSpan(Pixel::Mode mode, float fBlend, const std::function<olc::Pixel(const int x, const int y, const olc::Pixel&, const olc::Pixel&)>& custom, Pixel* data, int32_t w, int32_t h, DrawFunc draw)
+	{
+		switch (mode)
+		{
+		case Pixel::NORMAL:
+			draw([&](int32_t x0, int32_t x1, int32_t y, Pixel c) { WriteSpan<Pixel::NORMAL>(data, w, h, x0, x1, y, c, fBlend, custom); });
+			break;
+
+		case Pixel::MASK:
+			draw([&](int32_t x0, int32_t x1, int32_t y, Pixel c) { WriteSpan<Pixel::MASK>(data, w, h, x0, x1, y, c, fBlend, custom); });
+			break;
+
+		case Pixel::ALPHA:
+			draw([&](int32_t x0, int32_t x1, int32_t y, Pixel c) { WriteSpan<Pixel::ALPHA>(data, w, h, x0, x1, y, c, fBlend, custom); });
+			break;
+
+		case Pixel::CUSTOM:
+			draw([&](int32_t x0, int32_t x1, int32_t y, Pixel c) { WriteSpan<Pixel::CUSTOM>(data, w, h, x0, x1, y, c, fBlend, custom); });
+			break;
+		}
+	}
+
+	void PixelGameEngine::FillSpan(int32_t x0, int32_t x1, int32_t y, Pixel p)
+	{
+		if (!pDrawTarget) return;
+		if (x1 < x0) std::swap(x0, x1);
+
+		WithPixelModeSpan(nPixelMode, fBlendFactor, funcPixelMode, pDrawTarget->GetData(), pDrawTarget->width, pDrawTarget->height,
+			[&](auto span) { span(x0, x1, y, p); });
+	}
+
+	void PixelGameEngine::BlendSpan(int32_t x0, int32_t x1, int32_t y, Pixel p)
+	{
+		if (!pDrawTarget) return;
+		if (x1 < x0) std::swap(x0, x1);
+
+		WriteSpan<Pixel::ALPHA>(pDrawTarget->GetData(), pDrawTarget->width, pDrawTarget->height, x0, x1, y, p, fBlendFactor, funcPixelMode);
+	}
+
+
+	// Minor axis steps the Bresenham loop has taken after k major axis steps, bias is 0 for the x major loop
+	// which steps on a zero error term and 1 for the y major loop which doesn't
+	static inline int64_t LineMinorSteps(int64_t k, int64_t minor, int64_t major, int64_t bias)
 	{
-		int x, y, dx, dy, dx1, dy1, px, py, xe, ye, i;
-		dx = x2 - x1; dy = y2 - y1;
+		return (2 * k * minor + major - bias) / (2 * major);
+	}
 
-		auto rol = [&](void) { pattern = (pattern << 1) | (pattern >> 31); return pattern & 1; };
+	// First k in [0, major + 1] at which LineMinorSteps reaches target, major + 1 if it never does
+	static int64_t LineFirstStep(int64_t target, int64_t minor, int64_t major, int64_t bias)
+	{
+		int64_t lo = 0, hi = major + 1;
+		while (lo < hi)
+		{
+			int64_t mid = lo + (hi - lo) / 2;
+			if (LineMinorSteps(mid, minor, major, bias) >= target) hi = mid; else lo = mid + 1;
+		}
+		return lo;
+	}
+
+	// Rasterizes the part of a line inside [cx0, cx1] x [cy0, cy1], entering the Bresenham loop at the first
+	// visible step with the error term it would have had, so the pixels match the unclipped line
+	template<typename PlotFunc>
+	static void DrawClippedLine(int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t cx0, int32_t cy0, int32_t cx1, int32_t cy1, PlotFunc plot)
+	{
+		const int64_t dx = int64_t(x2) - x1, dy = int64_t(y2) - y1;
 
-		// straight lines idea by gurkanctn
 		if (dx == 0) // Line is vertical
 		{
-			if (y2 < y1) std::swap(y1, y2);
-			for (y = y1; y <= y2; y++) if (rol()) Draw(x1, y, p);
+			if (x1 < cx0 || x1 > cx1) return;
+			int32_t ys = std::max(std::min(y1, y2), cy0), ye = std::min(std::max(y1, y2), cy1);
+			for (int32_t y = ys; y <= ye; y++) plot(x1, y);
 			return;
 		}
 
 		if (dy == 0) // Line is horizontal
 		{
-			if (x2 < x1) std::swap(x1, x2);
-			for (x = x1; x <= x2; x++) if (rol()) Draw(x, y1, p);
+			if (y1 < cy0 || y1 > cy1) return;
+			int32_t xs = std::max(std::min(x1, x2), cx0), xe = std::min(std::max(x1, x2), cx1);
+			for (int32_t x = xs; x <= xe; x++) plot(x, y1);
 			return;
 		}
 
-		// Line is Funk-aye
-		dx1 = abs(dx); dy1 = abs(dy);
-		px = 2 * dy1 - dx1;	py = 2 * dx1 - dy1;
-		if (dy1 <= dx1)
+		// Bounding box misses the clip rect
+		if (std::max(x1, x2) < cx0 || std::min(x1, x2) > cx1 || std::max(y1, y2) < cy0 || std::min(y1, y2) > cy1) return;
+
+		const bool xMajor = std::abs(dy) <= std::abs(dx);
+		const int64_t major = xMajor ? std::abs(dx) : std::abs(dy);
+		const int64_t minor = xMajor ? std::abs(dy) : std::abs(dx);
+		const int64_t bias = xMajor ? 0 : 1;
+		const int64_t sign = ((dx < 0) == (dy < 0)) ? 1 : -1;
+
+		// Far beyond any draw target, and the step maths would overflow
+		if (major > (int64_t(1) << 30)) return;
+
+		// DrawLine walks from the end with the smaller major coordinate
+		const bool fromFirst = xMajor ? dx >= 0 : dy >= 0;
+		const int64_t M0 = xMajor ? (fromFirst ? x1 : x2) : (fromFirst ? y1 : y2);
+		const int64_t m0 = xMajor ? (fromFirst ? y1 : y2) : (fromFirst ? x1 : x2);
+		const int64_t cM0 = xMajor ? cx0 : cy0, cM1 = xMajor ? cx1 : cy1;
+		const int64_t cm0 = xMajor ? cy0 : cx0, cm1 = xMajor ? cy1 : cx1;
+
+		int64_t kBegin = std::max(int64_t(0), cM0 - M0);
+		int64_t kEnd = std::min(major, cM1 - M0);
+
+		// Minor coordinate is monotonic in k, so the clip rows or columns map to one range of steps
+		if (sign > 0)
+		{
+			kBegin = std::max(kBegin, LineFirstStep(cm0 - m0, minor, major, bias));
+			kEnd = std::min(kEnd, LineFirstStep(cm1 - m0 + 1, minor, major, bias) - 1);
+		}
+		else
+		{
+			kBegin = std::max(kBegin, LineFirstStep(m0 - cm1, minor, major, bias));
+			kEnd = std::min(kEnd, LineFirstStep(m0 - cm0 + 1, minor, major, bias) - 1);
+		}
+
+		if (kBegin > kEnd) return;
+
+		int64_t n = LineMinorSteps(kBegin, minor, major, bias);
+		int64_t e = 2 * minor - major + 2 * kBegin * minor - 2 * n * major;
+		int32_t M = int32_t(M0 + kBegin), m = int32_t(m0 + sign * n);
+		const int32_t step = int32_t(sign);
+
+		if (xMajor)
 		{
-			if (dx >= 0)
+			for (int64_t k = kBegin; k <= kEnd; k++, M++)
 			{
-				x = x1; y = y1; xe = x2;
+				plot(M, m);
+				if (e >= 0) { m += step; e -= 2 * major; }
+				e += 2 * minor;
 			}
-			else
+		}
+		else
+		{
+			for (int64_t k = kBegin; k <= kEnd; k++, M++)
 			{
-				x = x2; y = y2; xe = x1;
+				plot(m, M);
+				if (e > 0) { m += step; e -= 2 * major; }
+				e += 2 * minor;
 			}
+		}
+	}
+
+	// Calls draw with a plot(x, y, colour) functor for the pixel mode, so batch routines pick the mode once rather
+	// than per pixel. Coordinates must already be inside the w wide target
+	template<typename DrawFunc>
+	static void WithPixelModePlot(Pixel::Mode mode, float fBlend, const std::function<olc::Pixel(const int x, const int y, const olc::Pixel&, const olc::Pixel&)>& custom, Pixel* data, int32_t w, DrawFunc draw)
+	{
+		switch (mode)
+		{
+		case Pixel::NORMAL:
+			draw([=](int32_t x, int32_t y, Pixel c) { data[y * w + x] = c; });
+			break;
 
-			if (rol()) Draw(x, y, p);
+		case Pixel::MASK:
+			draw([=](int32_t x, int32_t y, Pixel c) { if (c.a == 255) data[y * w + x] = c; });
+			break;
 
-			for (i = 0; x < xe; i++)
+		case Pixel::ALPHA:
+			draw([=](int32_t x, int32_t y, Pixel c)
 			{
-				x = x + 1;
-				if (px < 0)
-					px = px + 2 * dy1;
-				else
-				{
-					if ((dx < 0 && dy < 0) || (dx > 0 && dy > 0)) y = y + 1; else y = y - 1;
-					px = px + 2 * (dy1 - dx1);
-				}
-				if (rol()) Draw(x, y, p);
-			}
+				Pixel& d = data[y * w + x];
+				float a = (float)(c.a / 255.0f) * fBlend;
+				float ca = 1.0f - a;
+				d = Pixel((uint8_t)(a * (float)c.r + ca * (float)d.r), (uint8_t)(a * (float)c.g + ca * (float)d.g), (uint8_t)(a * (float)c.b + ca * (float)d.b));
+			});
+			break;
+
+		case Pixel::CUSTOM:
+			draw([&](int32_t x, int32_t y, Pixel c) { data[y * w + x] = custom(x, y, c, data[y * w + x]); });
+			break;
 		}
-		else
+	}
+
+	void PixelGameEngine::DrawLine(const olc::vi2d& pos1, const olc::vi2d& pos2, Pixel p, uint32_t pattern)
+	{
+		DrawLine(pos1.x, pos1.y, pos2.x, pos2.y, p, pattern);
+	}
+
+	void PixelGameEngine::DrawLine(int32_t x1, int32_t y1, int32_t x2, int32_t y2, Pixel p, uint32_t pattern)
+	{
+		if (!pDrawTarget) return;
+
+		// Solid rows are a span fill
+		if (y1 == y2 && pattern == 0xFFFFFFFF) { FillSpan(x1, x2, y1, p); return; }
+
+		const int32_t w = pDrawTarget->width, h = pDrawTarget->height;
+
+		// Everything else is clipped to the target before it is rasterized, so off screen parts cost nothing and
+		// the visible pixels are written without bounds checks
+		WithPixelModePlot(nPixelMode, fBlendFactor, funcPixelMode, pDrawTarget->GetData(), w, [&](auto plot)
 		{
-			if (dy >= 0)
+			if (pattern == 0xFFFFFFFF)
 			{
-				x = x1; y = y1; ye = y2;
+				DrawClippedLine(x1, y1, x2, y2, 0, 0, w - 1, h - 1, [&](int32_t x, int32_t y) { plot(x, y, p); });
+				return;
 			}
-			else
+
+			// The pattern rotates once per pixel from the end with the smaller major coordinate, so a pixel's bit
+			// follows from its distance along the major axis
+			const bool xMajor = std::abs(int64_t(y2) - y1) <= std::abs(int64_t(x2) - x1) && x1 != x2;
+			const int64_t start = xMajor ? std::min(x1, x2) : std::min(y1, y2);
+			DrawClippedLine(x1, y1, x2, y2, 0, 0, w - 1, h - 1, [&](int32_t x, int32_t y)
+			{
+				const int64_t i = (xMajor ? x : y) - start;
+				if ((pattern >> (31 - (i & 31))) & 1) plot(x, y, p);
+			});
+		});
+	}
+
+	void PixelGameEngine::DrawLines(const olc::LineSegment* lines, size_t count, Pixel p, int32_t yBegin, int32_t yEnd)
+	{
+		if (!pDrawTarget || count == 0) return;
+
+		const int32_t w = pDrawTarget->width;
+		const int32_t cy0 = std::max(yBegin, 0), cy1 = std::min(yEnd, int32_t(pDrawTarget->height)) - 1;
+		if (w <= 0 || cy0 > cy1) return;
+
+		WithPixelModePlot(nPixelMode, fBlendFactor, funcPixelMode, pDrawTarget->GetData(), w, [&](auto plot)
+		{
+			for (size_t i = 0; i < count; i++)
+				DrawClippedLine(lines[i].x1, lines[i].y1, lines[i].x2, lines[i].y2, 0, cy0, w - 1, cy1, [&](int32_t x, int32_t y) { plot(x, y, p); });
+		});
+	}
+
+	// Calls span(y, x0, x1) for each row of pixels, inclusive, whose centres are inside the triangle, clipped to
+	// columns [0, w) and rows [cy0, cy1]. Pixel centres exactly on an edge belong to the triangle only if the edge
+	// faces a fixed direction, so a pixel on an edge shared by two triangles is filled once
+	template<typename SpanFunc>
+	static void RasterTriangle(olc::vf2d v0, olc::vf2d v1, olc::vf2d v2, int32_t w, int32_t cy0, int32_t cy1, SpanFunc span)
+	{
+		// Edge function E(p) = A * p.x + B * p.y + C, positive inside once the winding is fixed up
+		auto edge = [](const olc::vf2d& a, const olc::vf2d& b, float& A, float& B, float& C) { A = a.y - b.y; B = b.x - a.x; C = a.x * b.y - a.y * b.x; };
+
+		float A[3], B[3], C[3];
+		edge(v0, v1, A[0], B[0], C[0]);
+		float area = A[0] * v2.x + B[0] * v2.y + C[0];
+		if (area < 0.0f) { std::swap(v1, v2); edge(v0, v1, A[0], B[0], C[0]); area = -area; }
+		if (!(area > 0.0f)) return; // Degenerate or not a number
+		edge(v1, v2, A[1], B[1], C[1]);
+		edge(v2, v0, A[2], B[2], C[2]);
+
+		const float fy0 = std::max(float(cy0), std::ceil(std::min({ v0.y, v1.y, v2.y }) - 0.5f));
+		const float fy1 = std::min(float(cy1), std::floor(std::max({ v0.y, v1.y, v2.y }) - 0.5f));
+		if (!(fy0 <= fy1)) return;
+
+		for (int32_t y = int32_t(fy0); y <= int32_t(fy1); y++)
+		{
+			const float yc = float(y) + 0.5f;
+			float fx0 = 0.0f, fx1 = float(w - 1);
+
+			for (int e = 0; e < 3; e++)
 			{
-				x = x2; y = y2; ye = y1;
+				const float row = B[e] * yc + C[e];
+				if (A[e] > 0.0f)
+					fx0 = std::max(fx0, std::ceil(-row / A[e] - 0.5f));         // Inclusive edge
+				else if (A[e] < 0.0f)
+					fx1 = std::min(fx1, std::ceil(-row / A[e] - 0.5f) - 1.0f);  // Exclusive edge
+				else if (B[e] > 0.0f ? row < 0.0f : row <= 0.0f)
+					fx1 = -1.0f;                                                 // Row outside a horizontal edge
 			}
 
-			if (rol()) Draw(x, y, p);
+			if (fx0 <= fx1) span(y, int32_t(fx0), int32_t(fx1));
+		}
+	}
+
+	void PixelGameEngine::FillTriangles(const olc::vf2d* pos, const olc::vf2d* uv, size_t vertices, olc::Sprite* sprite, Pixel tint, int32_t yBegin, int32_t yEnd)
+	{
+		if (!pDrawTarget || vertices < 3) return;
+
+		const int32_t w = pDrawTarget->width;
+		const int32_t cy0 = std::max(yBegin, 0), cy1 = std::min(yEnd, int32_t(pDrawTarget->height)) - 1;
+		if (w <= 0 || cy0 > cy1) return;
+
+		const bool bTextured = sprite != nullptr && uv != nullptr && sprite->width > 0 && sprite->height > 0;
+		const bool bTinted = tint != olc::WHITE;
 
-			for (i = 0; y < ye; i++)
+		WithPixelModePlot(nPixelMode, fBlendFactor, funcPixelMode, pDrawTarget->GetData(), w, [&](auto plot)
+		{
+			for (size_t i = 0; i + 2 < vertices; i += 3)
 			{
-				y = y + 1;
-				if (py <= 0)
-					py = py + 2 * dx1;
-				else
+				const olc::vf2d& a = pos[i];
+				const olc::vf2d& b = pos[i + 1];
+				const olc::vf2d& c = pos[i + 2];
+
+				if (!bTextured)
 				{
-					if ((dx < 0 && dy < 0) || (dx > 0 && dy > 0)) x = x + 1; else x = x - 1;
-					py = py + 2 * (dx1 - dy1);
+					RasterTriangle(a, b, c, w, cy0, cy1, [&](int32_t y, int32_t x0, int32_t x1) { for (int32_t x = x0; x <= x1; x++) plot(x, y, tint); });
+					continue;
 				}
-				if (rol()) Draw(x, y, p);
+
+				// uv is linear in screen space, solve its gradient once per triangle and step it along each span
+				const olc::vf2d d1 = b - a, d2 = c - a;
+				const float det = d1.x * d2.y - d1.y * d2.x;
+				if (det == 0.0f) continue;
+				const olc::vf2d du1 = uv[i + 1] - uv[i], du2 = uv[i + 2] - uv[i];
+				const olc::vf2d dx = (du1 * d2.y - du2 * d1.y) / det;
+				const olc::vf2d dy = (du2 * d1.x - du1 * d2.x) / det;
+				const float sw = float(sprite->width), sh = float(sprite->height);
+				const Pixel* tex = sprite->GetData();
+
+				RasterTriangle(a, b, c, w, cy0, cy1, [&](int32_t y, int32_t x0, int32_t x1)
+				{
+					olc::vf2d t = uv[i] + dx * (float(x0) + 0.5f - a.x) + dy * (float(y) + 0.5f - a.y);
+					for (int32_t x = x0; x <= x1; x++, t += dx)
+					{
+						// Clamp like the decal path, written so a not a number lands on 0
+						float tx = t.x * sw, ty = t.y * sh;
+						tx = !(tx >= 0.0f) ? 0.0f : (tx > sw - 1.0f ? sw - 1.0f : tx);
+						ty = !(ty >= 0.0f) ? 0.0f : (ty > sh - 1.0f ? sh - 1.0f : ty);
+						Pixel col = tex[int32_t(ty) * sprite->width + int32_t(tx)];
+						if (bTinted)
+							col = Pixel(uint8_t(col.r * tint.r / 255), uint8_t(col.g * tint.g / 255), uint8_t(col.b * tint.b / 255), uint8_t(col.a * tint.a / 255));
+						plot(x, y, col);
+					}
+				});
 			}
-		}
+		});
 	}
 
 	void PixelGameEngine::DrawCircle(const olc::vi2d& pos, int32_t radius, Pixel p, uint8_t mask)
@@ -2092,11 +2531,7 @@ namespace olc
 			int y0 = radius;
 			int d = 3 - 2 * radius;
 
-			auto drawline = [&](int sx, int ex, int y)
-			{
-				for (int x = sx; x <= ex; x++)
-					Draw(x, y, p);
-			};
+			auto drawline = [&](int sx, int ex, int y) { FillSpan(sx, ex, y, p); };
 
 			while (y0 >= x0)
 			{
@@ -2120,6 +2555,25 @@ namespace olc
 			Draw(x, y, p);
 	}
 
+	void PixelGameEngine::DrawStamp(const olc::vi2d& pos, const olc::Stamp& stamp, Pixel p)
+	{
+		DrawStamp(pos.x, pos.y, stamp, p);
+	}
+
+	void PixelGameEngine::DrawStamp(int32_t x, int32_t y, const olc::Stamp& stamp, Pixel p)
+	{
+		if (!pDrawTarget || stamp.IsEmpty()) return;
+
+		const int32_t w = pDrawTarget->width, h = pDrawTarget->height;
+		if (x + stamp.right < 0 || x + stamp.left >= w || y + stamp.bottom < 0 || y + stamp.top >= h) return;
+
+		WithPixelModeSpan(nPixelMode, fBlendFactor, funcPixelMode, pDrawTarget->GetData(), w, h, [&](auto fill)
+		{
+			for (const auto& span : stamp.GetSpans())
+				fill(x + span.x0, x + span.x1, y + span.y, p);
+		});
+	}
+
 	void PixelGameEngine::DrawRect(const olc::vi2d& pos, const olc::vi2d& size, Pixel p)
 	{
 		DrawRect(pos.x, pos.y, size.x, size.y, p);
@@ -2135,9 +2589,8 @@ namespace olc
 
 	void PixelGameEngine::Clear(Pixel p)
 	{
-		int pixels = GetDrawTargetWidth() * GetDrawTargetHeight();
-		Pixel* m = GetDrawTarget()->GetData();
-		for (int i = 0; i < pixels; i++) m[i] = p;
+		if (!pDrawTarget) return;
+		FillPixels(pDrawTarget->GetData(), size_t(pDrawTarget->width) * size_t(pDrawTarget->height), p);
 	}
 
 	void PixelGameEngine::ClearBuffer(Pixel p, bool bDepth)
@@ -2170,9 +2623,13 @@ namespace olc
 		if (y2 < 0) y2 = 0;
 		if (y2 >= (int32_t)GetDrawTargetHeight()) y2 = (int32_t)GetDrawTargetHeight();
 
-		for (int i = x; i < x2; i++)
+		if (!pDrawTarget || x >= x2) return;
+
+		WithPixelModeSpan(nPixelMode, fBlendFactor, funcPixelMode, pDrawTarget->GetData(), pDrawTarget->width, pDrawTarget->height, [&](auto span)
+		{
 			for (int j = y; j < y2; j++)
-				Draw(i, j, p);
+				span(x, x2 - 1, j, p);
+		});
 	}
 
 	void PixelGameEngine::DrawTriangle(const olc::vi2d& pos1, const olc::vi2d& pos2, const olc::vi2d& pos3, Pixel p)
@@ -2195,7 +2652,7 @@ namespace olc
 	// https://www.avrfreaks.net/sites/default/files/triangles.c
 	void PixelGameEngine::FillTriangle(int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t x3, int32_t y3, Pixel p)
 	{
-		auto drawline = [&](int sx, int ex, int ny) { for (int i = sx; i <= ex; i++) Draw(i, ny, p); };
+		auto drawline = [&](int sx, int ex, int ny) { FillSpan(sx, ex, ny, p); };
 
 		int t1x, t2x, y, minx, maxx, t1xp, t2xp;
 		bool changed1 = false;
@@ -2532,6 +2989,25 @@ namespace olc
 		vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 	}
 
+	void PixelGameEngine::DrawTrianglesDecal(olc::Decal* decal, const olc::vf2d* pos, const olc::vf2d* uv, uint32_t vertices, const olc::Pixel tint)
+	{
+		DecalInstance di;
+		di.decal = decal;
+		di.structure = olc::DecalStructure::LIST;
+		di.points = vertices - vertices % 3;
+		di.pos.resize(di.points);
+		di.uv.resize(di.points);
+		di.w.assign(di.points, 1.0f);
+		di.tint.assign(di.points, tint);
+		for (uint32_t i = 0; i < di.points; i++)
+		{
+			di.pos[i] = { (pos[i].x * vInvScreenSize.x) * 2.0f - 1.0f, ((pos[i].y * vInvScreenSize.y) * 2.0f - 1.0f) * -1.0f };
+			di.uv[i] = uv != nullptr ? uv[i] : olc::vf2d{ 0.0f, 0.0f };
+		}
+		di.mode = nDecalMode;
+		vLayers[nTargetLayer].vecDecalInstance.push_back(std::move(di));
+	}
+
 	void PixelGameEngine::FillRectDecal(const olc::vf2d& pos, const olc::vf2d& size, const olc::Pixel col)
 	{
 		std::array<olc::vf2d, 4> points = { { {pos}, {pos.x, pos.y + size.y}, {pos + size}, {pos.x + size.x, pos.y} } };
@@ -3478,10 +3954,17 @@ namespace olc
 			else
 				glBindTexture(GL_TEXTURE_2D, decal.decal->id);
 
-			if (nDecalMode == DecalMode::WIREFRAME)
+			const bool bList = decal.structure == DecalStructure::LIST;
+
+			if (nDecalMode == DecalMode::WIREFRAME && bList)
+			{
+				glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+				glBegin(GL_TRIANGLES);
+			}
+			else if (nDecalMode == DecalMode::WIREFRAME)
 				glBegin(GL_LINE_LOOP);
 			else
-				glBegin(GL_TRIANGLE_FAN);
+				glBegin(bList ? GL_TRIANGLES : GL_TRIANGLE_FAN);
 
 			for (uint32_t n = 0; n < decal.points; n++)
 			{
@@ -3490,6 +3973,9 @@ namespace olc
 				glVertex2f(decal.pos[n].x, decal.pos[n].y);
 			}
 			glEnd();
+
+			if (nDecalMode == DecalMode::WIREFRAME && bList)
+				glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 		}
 
 		uint32_t CreateTexture(const uint32_t width, const uint32_t height, const bool filtered) override
@@ -3680,7 +4166,8 @@ namespace olc
 			olc::Pixel col;
 		};
 
-		locVertex pVertexMem[OLC_MAX_VERTS];
+		// Grows to the largest decal drawn, triangle lists can hold far more than OLC_MAX_VERTS
+		std::vector<locVertex> pVertexMem;
 
 		olc::Renderable rendBlankQuad;
 
@@ -3933,15 +4420,26 @@ namespace olc
 
 			locBindBuffer(0x8892, m_vbQuad);
 
+			if (pVertexMem.size() < decal.points)
+				pVertexMem.resize(decal.points);
+
 			for (uint32_t i = 0; i < decal.points; i++)
 				pVertexMem[i] = { { decal.pos[i].x, decal.pos[i].y, decal.w[i] }, { decal.uv[i].x, decal.uv[i].y }, decal.tint[i] };
 
-			locBufferData(0x8892, sizeof(locVertex) * decal.points, pVertexMem, 0x88E0);
+			locBufferData(0x8892, sizeof(locVertex) * decal.points, pVertexMem.data(), 0x88E0);
 
-			if (nDecalMode == DecalMode::WIREFRAME)
+			const bool bList = decal.structure == DecalStructure::LIST;
+
+			if (nDecalMode == DecalMode::WIREFRAME && bList)
+			{
+				glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+				glDrawArrays(GL_TRIANGLES, 0, decal.points);
+				glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+			}
+			else if (nDecalMode == DecalMode::WIREFRAME)
 				glDrawArrays(GL_LINE_LOOP, 0, decal.points);
 			else
-				glDrawArrays(GL_TRIANGLE_FAN, 0, decal.points);
+				glDrawArrays(bList ? GL_TRIANGLES : GL_TRIANGLE_FAN, 0, decal.points);
 		}
 
 		uint32_t CreateTexture(const uint32_t width, const uint32_t height, const bool filtered) override